@@ -3,7 +3,26 @@
 #include <string.h>
 #include <stdio.h>
 #include "devices/ide.h"
+#include "devices/timer.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Number of buckets in a latency histogram.  Bucket I counts
+   requests whose latency, in CPU cycles, was in the range
+   [2**I, 2**(I+1)), except that bucket 0 also counts requests
+   that took 0 cycles. */
+#define HIST_BUCKETS 48
+
+/* Statistics for one direction (reads or writes) of a block
+   device. */
+struct block_io_stats
+  {
+    unsigned long long cnt;             /* Number of sectors. */
+    unsigned long long seq_cnt;         /* Number of sequential sectors. */
+    unsigned long long wait_cycles;     /* Cycles spent queued. */
+    unsigned long long service_cycles;  /* Cycles spent in the driver. */
+    unsigned long long hist[HIST_BUCKETS]; /* Latency histogram. */
+  };
 
 /* A block device. */
 struct block
@@ -17,8 +36,10 @@ struct block
     const struct block_operations *ops;  /* Driver operations. */
     void *aux;                          /* Extra data owned by driver. */
 
-    unsigned long long read_cnt;        /* Number of sectors read. */
-    unsigned long long write_cnt;       /* Number of sectors written. */
+    struct lock lock;                   /* Serializes requests. */
+    block_sector_t next_sector;         /* Sector after last request. */
+    struct block_io_stats read_stats;   /* Read statistics. */
+    struct block_io_stats write_stats;  /* Write statistics. */
   };
 
 /* List of all block devices. */
@@ -113,6 +134,51 @@ check_sector (struct block *block, block_sector_t sector)
     }
 }
 
+/* Returns the index of the most significant 1-bit in X, or 0 if
+   X is 0. */
+static int
+log2_floor (uint64_t x)
+{
+  int bit = 0;
+  while (x >>= 1)
+    bit++;
+  return bit;
+}
+
+/* Waits for BLOCK to become idle and claims it for a request
+   on SECTOR.  Returns the cycle count at which the request was
+   made, for passing to end_request(). */
+static uint64_t
+begin_request (struct block *block, block_sector_t sector)
+{
+  uint64_t start = timer_cycles ();
+
+  check_sector (block, sector);
+  lock_acquire (&block->lock);
+  return start;
+}
+
+/* Finishes a request on SECTOR of BLOCK that was issued at cycle
+   START and was passed to the driver at cycle ISSUE, accounting
+   it in STATS, and releases BLOCK for the next request. */
+static void
+end_request (struct block *block, struct block_io_stats *stats,
+             block_sector_t sector, uint64_t start, uint64_t issue)
+{
+  uint64_t end = timer_cycles ();
+  int bucket = log2_floor (end - start);
+
+  stats->cnt++;
+  if (sector == block->next_sector)
+    stats->seq_cnt++;
+  stats->wait_cycles += issue - start;
+  stats->service_cycles += end - issue;
+  stats->hist[bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1]++;
+  block->next_sector = sector + 1;
+
+  lock_release (&block->lock);
+}
+
 /* Reads sector SECTOR from BLOCK into BUFFER, which must
    have room for BLOCK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to block devices, so external
@@ -120,9 +186,10 @@ check_sector (struct block *block, block_sector_t sector)
 void
 block_read (struct block *block, block_sector_t sector, void *buffer)
 {
-  check_sector (block, sector);
+  uint64_t start = begin_request (block, sector);
+  uint64_t issue = timer_cycles ();
   block->ops->read (block->aux, sector, buffer);
-  block->read_cnt++;
+  end_request (block, &block->read_stats, sector, start, issue);
 }
 
 /* Write sector SECTOR to BLOCK from BUFFER, which must contain
@@ -133,10 +200,40 @@ block_read (struct block *block, block_sector_t sector, void *buffer)
 void
 block_write (struct block *block, block_sector_t sector, const void *buffer)
 {
-  check_sector (block, sector);
+  uint64_t start, issue;
+
   ASSERT (block->type != BLOCK_FOREIGN);
+  start = begin_request (block, sector);
+  issue = timer_cycles ();
   block->ops->write (block->aux, sector, buffer);
-  block->write_cnt++;
+  end_request (block, &block->write_stats, sector, start, issue);
+}
+
+/* Writes any data that BLOCK's driver is holding in memory to
+   the underlying device.  Drivers that do not buffer writes
+   need not provide a flush operation. */
+void
+block_flush (struct block *block)
+{
+  if (block->ops->flush != NULL)
+    {
+      lock_acquire (&block->lock);
+      block->ops->flush (block->aux);
+      lock_release (&block->lock);
+    }
+}
+
+/* Flushes every block device.  Devices are flushed in reverse
+   probe order, so that a device stacked on top of another one
+   is flushed before the device beneath it. */
+void
+block_flush_all (void)
+{
+  struct list_elem *e;
+
+  for (e = list_rbegin (&all_blocks); e != list_rend (&all_blocks);
+       e = list_prev (e))
+    block_flush (list_entry (e, struct block, list_elem));
 }
 
 /* Returns the number of sectors in BLOCK. */
@@ -160,6 +257,25 @@ block_type (struct block *block)
   return block->type;
 }
 
+/* Prints the statistics in S, which describe requests of the
+   given KIND ("read" or "write"). */
+static void
+print_io_stats (const char *kind, const struct block_io_stats *s)
+{
+  int i;
+
+  if (s->cnt == 0)
+    return;
+
+  printf ("  %s: %'llu bytes, %llu sequential, %llu random, "
+          "avg %llu cycles queued, avg %llu cycles in service\n",
+          kind, s->cnt * BLOCK_SECTOR_SIZE, s->seq_cnt, s->cnt - s->seq_cnt,
+          s->wait_cycles / s->cnt, s->service_cycles / s->cnt);
+  for (i = 0; i < HIST_BUCKETS; i++)
+    if (s->hist[i] != 0)
+      printf ("    %s latency < 2^%d cycles: %llu\n", kind, i + 1, s->hist[i]);
+}
+
 /* Prints statistics for each block device used for a Pintos role. */
 void
 block_print_stats (void)
@@ -173,7 +289,9 @@ block_print_stats (void)
         {
           printf ("%s (%s): %llu reads, %llu writes\n",
                   block->name, block_type_name (block->type),
-                  block->read_cnt, block->write_cnt);
+                  block->read_stats.cnt, block->write_stats.cnt);
+          print_io_stats ("read", &block->read_stats);
+          print_io_stats ("write", &block->write_stats);
         }
     }
 }
@@ -198,8 +316,10 @@ block_register (const char *name, enum block_type type,
   block->size = size;
   block->ops = ops;
   block->aux = aux;
-  block->read_cnt = 0;
-  block->write_cnt = 0;
+  lock_init (&block->lock);
+  block->next_sector = 0;
+  memset (&block->read_stats, 0, sizeof block->read_stats);
+  memset (&block->write_stats, 0, sizeof block->write_stats);
 
   printf ("%s: %'"PRDSNu" sectors (", block->name, block->size);
   print_human_readable_size ((uint64_t) block->size * BLOCK_SECTOR_SIZE);
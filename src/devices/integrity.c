@@ -0,0 +1,300 @@
+#include "devices/integrity.h"
+#include <crc32c.h>
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+
+/* An integrity device stacks on top of another block device,
+   its "parent", the same way a partition does, and stores a
+   CRC-32C checksum of each sector in an area reserved at the end
+   of the parent.  Every read is verified against the stored
+   checksum and a mismatch panics the kernel, naming the bad
+   sector, instead of handing corrupt data to the file system.
+
+   The parent is laid out as follows:
+
+        +-------------------+--------+------------------+
+        | data sectors      | header | checksum sectors |
+        +-------------------+--------+------------------+
+        0                   D        D+1                N
+
+   Data sector S of the integrity device is parent sector S.
+   Checksum sector I holds the checksums of data sectors
+   I*CRCS_PER_SECTOR through (I+1)*CRCS_PER_SECTOR - 1.
+
+   Checksum sectors are cached in memory and only written back
+   when evicted from the cache or when the device is flushed,
+   so that a run of writes to neighboring sectors costs one
+   checksum sector write instead of one per data sector.  So
+   that a crash before the flush does not leave stale checksums
+   to be trusted on the next boot, the header is marked dirty on
+   disk before the first cached checksum changes and marked
+   clean again once a flush has written them all back.  Attaching
+   to a device whose header is dirty recomputes every checksum
+   from the data. */
+
+/* Number of checksums in a checksum sector. */
+#define CRCS_PER_SECTOR (BLOCK_SECTOR_SIZE / sizeof (uint32_t))
+
+/* Number of checksum sectors cached per device. */
+#define CACHE_CNT 8
+
+/* Identifies an integrity device header. */
+#define INTEGRITY_MAGIC 0x43524343
+
+/* On-disk header.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct integrity_header
+  {
+    unsigned magic;                     /* INTEGRITY_MAGIC. */
+    block_sector_t data_sectors;        /* Number of data sectors. */
+    unsigned dirty;                     /* Checksums on disk stale? */
+    uint32_t unused[125];               /* Not used. */
+  };
+
+/* A cached checksum sector. */
+struct crc_sector
+  {
+    block_sector_t idx;                 /* Checksum sector number. */
+    bool in_use;                        /* Does this entry hold data? */
+    bool dirty;                         /* Needs to be written back? */
+    unsigned last_use;                  /* Time of last use, for LRU. */
+    uint32_t crcs[CRCS_PER_SECTOR];     /* Checksums. */
+  };
+
+/* An integrity device.  The block layer serializes calls to a
+   device's operations, so the members below need no lock of
+   their own. */
+struct integrity
+  {
+    struct block *parent;               /* Underlying block device. */
+    block_sector_t data_sectors;        /* Number of data sectors. */
+    struct integrity_header header;     /* Copy of on-disk header. */
+    unsigned clock;                     /* Incremented on each access. */
+    struct crc_sector cache[CACHE_CNT]; /* Cached checksum sectors. */
+  };
+
+static struct block_operations integrity_operations;
+
+static void initialize_checksums (struct integrity *);
+static struct crc_sector *get_crc_sector (struct integrity *, size_t idx,
+                                          bool load);
+static void flush_crc_sector (struct integrity *, struct crc_sector *);
+static void flush_all (struct integrity *);
+static void write_header (struct integrity *, bool dirty);
+
+/* Stacks a new integrity device on top of PARENT and returns it.
+   The new device has PARENT's type and a name formed by
+   appending "-crc" to PARENT's name.
+
+   The header and checksums occupy the last sectors of PARENT.
+   If PARENT has not been used as an integrity device before,
+   those sectors may hold data, so the device is set up only if
+   FORMAT is true, meaning that PARENT's contents are about to
+   be discarded anyway; then checksums are computed for all of
+   its current data sectors.  If PARENT was not cleanly detached,
+   its checksums are recomputed the same way.
+
+   Returns a null pointer if PARENT is too small or if it has no
+   integrity header and FORMAT is false. */
+struct block *
+integrity_attach (struct block *parent, bool format)
+{
+  block_sector_t size = block_size (parent);
+  struct integrity_header *h;
+  struct integrity *in;
+  char name[16];
+  block_sector_t d;
+
+  /* Find the largest number of data sectors that leaves room
+     for the header and enough checksum sectors to cover them. */
+  if (size < 3)
+    return NULL;
+  d = (size - 1) / (CRCS_PER_SECTOR + 1) * CRCS_PER_SECTOR;
+  while (d + 2 + DIV_ROUND_UP (d + 1, CRCS_PER_SECTOR) <= size)
+    d++;
+
+  crc32c_init ();
+  in = calloc (1, sizeof *in);
+  if (in == NULL)
+    PANIC ("Failed to allocate memory for integrity device");
+  in->parent = parent;
+  in->data_sectors = d;
+
+  ASSERT (sizeof *h == BLOCK_SECTOR_SIZE);
+  h = &in->header;
+  block_read (parent, d, h);
+  if (h->magic != INTEGRITY_MAGIC || h->data_sectors != d)
+    {
+      if (!format)
+        {
+          printf ("%s: no integrity header, not formatting\n",
+                  block_name (parent));
+          free (in);
+          return NULL;
+        }
+      memset (h, 0, sizeof *h);
+      h->magic = INTEGRITY_MAGIC;
+      h->data_sectors = d;
+      h->dirty = true;
+    }
+  if (h->dirty)
+    {
+      /* The checksums on disk may not match the data, so replace
+         them, and mark them clean only once they are written. */
+      initialize_checksums (in);
+      flush_all (in);
+      write_header (in, false);
+    }
+
+  snprintf (name, sizeof name, "%s-crc", block_name (parent));
+  return block_register (name, block_type (parent), "CRC-32C checked", d,
+                         &integrity_operations, in);
+}
+
+/* Computes and writes checksums for every data sector of IN. */
+static void
+initialize_checksums (struct integrity *in)
+{
+  uint8_t *buffer = malloc (BLOCK_SECTOR_SIZE);
+  block_sector_t sector;
+
+  if (buffer == NULL)
+    PANIC ("Failed to allocate memory for integrity initialization");
+  printf ("%s: computing checksums for %'"PRDSNu" sectors\n",
+          block_name (in->parent), in->data_sectors);
+  for (sector = 0; sector < in->data_sectors; sector++)
+    {
+      struct crc_sector *cs = get_crc_sector (in, sector / CRCS_PER_SECTOR,
+                                              false);
+      block_read (in->parent, sector, buffer);
+      cs->crcs[sector % CRCS_PER_SECTOR] = crc32c (buffer, BLOCK_SECTOR_SIZE);
+      cs->dirty = true;
+    }
+  free (buffer);
+}
+
+/* Returns the cache entry for checksum sector IDX of IN,
+   evicting the least recently used entry if necessary.  If LOAD
+   is true, a newly cached sector is read from disk; otherwise,
+   the caller must overwrite every checksum in it. */
+static struct crc_sector *
+get_crc_sector (struct integrity *in, size_t idx, bool load)
+{
+  struct crc_sector *victim = NULL;
+  size_t i;
+
+  in->clock++;
+  for (i = 0; i < CACHE_CNT; i++)
+    {
+      struct crc_sector *cs = &in->cache[i];
+      if (cs->in_use && cs->idx == idx)
+        {
+          cs->last_use = in->clock;
+          return cs;
+        }
+      if (victim == NULL
+          || (victim->in_use
+              && (!cs->in_use || cs->last_use < victim->last_use)))
+        victim = cs;
+    }
+
+  flush_crc_sector (in, victim);
+  victim->idx = idx;
+  victim->in_use = true;
+  victim->dirty = false;
+  victim->last_use = in->clock;
+  if (load)
+    block_read (in->parent, in->data_sectors + 1 + idx, victim->crcs);
+  return victim;
+}
+
+/* Writes CS back to IN's parent device if it is dirty. */
+static void
+flush_crc_sector (struct integrity *in, struct crc_sector *cs)
+{
+  if (cs->in_use && cs->dirty)
+    {
+      block_write (in->parent, in->data_sectors + 1 + cs->idx, cs->crcs);
+      cs->dirty = false;
+    }
+}
+
+/* Writes back all of IN's dirty checksum sectors. */
+static void
+flush_all (struct integrity *in)
+{
+  size_t i;
+
+  for (i = 0; i < CACHE_CNT; i++)
+    flush_crc_sector (in, &in->cache[i]);
+}
+
+/* Writes IN's header to disk, marked DIRTY. */
+static void
+write_header (struct integrity *in, bool dirty)
+{
+  in->header.dirty = dirty;
+  block_write (in->parent, in->data_sectors, &in->header);
+}
+
+/* Reads sector SECTOR from integrity device IN into BUFFER,
+   which must have room for BLOCK_SECTOR_SIZE bytes, and verifies
+   its checksum.  Panics if the checksum does not match. */
+static void
+integrity_read (void *in_, block_sector_t sector, void *buffer)
+{
+  struct integrity *in = in_;
+  struct crc_sector *cs;
+  uint32_t expected, actual;
+
+  block_read (in->parent, sector, buffer);
+  cs = get_crc_sector (in, sector / CRCS_PER_SECTOR, true);
+  expected = cs->crcs[sector % CRCS_PER_SECTOR];
+  actual = crc32c (buffer, BLOCK_SECTOR_SIZE);
+  if (actual != expected)
+    PANIC ("%s: checksum mismatch in sector %"PRDSNu" "
+           "(expected %08"PRIx32", got %08"PRIx32")",
+           block_name (in->parent), sector, expected, actual);
+}
+
+/* Writes sector SECTOR to integrity device IN from BUFFER, which
+   must contain BLOCK_SECTOR_SIZE bytes, and updates its
+   checksum.  The checksum reaches the disk later, when its
+   checksum sector is written back, so the header is marked
+   dirty first if it is not already. */
+static void
+integrity_write (void *in_, block_sector_t sector, const void *buffer)
+{
+  struct integrity *in = in_;
+  struct crc_sector *cs;
+
+  if (!in->header.dirty)
+    write_header (in, true);
+  block_write (in->parent, sector, buffer);
+  cs = get_crc_sector (in, sector / CRCS_PER_SECTOR, true);
+  cs->crcs[sector % CRCS_PER_SECTOR] = crc32c (buffer, BLOCK_SECTOR_SIZE);
+  cs->dirty = true;
+}
+
+/* Writes all of IN's dirty checksum sectors to disk and marks
+   the header clean. */
+static void
+integrity_flush (void *in_)
+{
+  struct integrity *in = in_;
+
+  flush_all (in);
+  if (in->header.dirty)
+    write_header (in, false);
+}
+
+static struct block_operations integrity_operations =
+  {
+    integrity_read,
+    integrity_write,
+    integrity_flush
+  };
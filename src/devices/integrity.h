@@ -0,0 +1,10 @@
+#ifndef DEVICES_INTEGRITY_H
+#define DEVICES_INTEGRITY_H
+
+#include <stdbool.h>
+
+struct block;
+
+struct block *integrity_attach (struct block *, bool format);
+
+#endif /* devices/integrity.h */
@@ -320,5 +320,6 @@ partition_write (void *p_, block_sector_t sector, const void *buffer)
 static struct block_operations partition_operations =
   {
     partition_read,
-    partition_write
+    partition_write,
+    NULL
   };
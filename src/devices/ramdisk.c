@@ -0,0 +1,91 @@
+#include "devices/ramdisk.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A RAM disk: a block device whose sectors are kept in kernel
+   memory.  Reads and writes are plain memory copies, so a RAM
+   disk makes a zero-latency stand-in for an IDE disk when
+   measuring file system or virtual memory overhead.  Its
+   contents do not survive a reboot. */
+
+/* Number of sectors per page of RAM disk storage. */
+#define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* A RAM disk. */
+struct ramdisk
+  {
+    size_t page_cnt;            /* Number of pages of storage. */
+    uint8_t **pages;            /* Storage, one page at a time. */
+  };
+
+static struct block_operations ramdisk_operations;
+
+/* Creates a RAM disk named "ram0" with SIZE sectors and
+   registers it with the block layer as a raw device.  It can
+   then be assigned a role by name, e.g. with "-filesys=ram0".
+   The storage is taken from the kernel pool one page at a time,
+   so it need not be physically contiguous.  Panics if memory is
+   exhausted. */
+void
+ramdisk_init (block_sector_t size)
+{
+  struct ramdisk *rd;
+  size_t i;
+
+  if (size == 0)
+    return;
+
+  rd = malloc (sizeof *rd);
+  if (rd == NULL)
+    PANIC ("Failed to allocate memory for RAM disk descriptor");
+  rd->page_cnt = DIV_ROUND_UP (size, SECTORS_PER_PAGE);
+  rd->pages = malloc (rd->page_cnt * sizeof *rd->pages);
+  if (rd->pages == NULL)
+    PANIC ("Failed to allocate memory for RAM disk page table");
+  for (i = 0; i < rd->page_cnt; i++)
+    {
+      rd->pages[i] = palloc_get_page (PAL_ZERO);
+      if (rd->pages[i] == NULL)
+        PANIC ("ram0: out of memory after %zu of %zu pages",
+               i, rd->page_cnt);
+    }
+
+  block_register ("ram0", BLOCK_RAW, "RAM disk", size,
+                  &ramdisk_operations, rd);
+}
+
+/* Returns the address of sector SECTOR within RD. */
+static uint8_t *
+sector_address (const struct ramdisk *rd, block_sector_t sector)
+{
+  return (rd->pages[sector / SECTORS_PER_PAGE]
+          + sector % SECTORS_PER_PAGE * BLOCK_SECTOR_SIZE);
+}
+
+/* Reads sector SECTOR from RAM disk RD into BUFFER, which must
+   have room for BLOCK_SECTOR_SIZE bytes. */
+static void
+ramdisk_read (void *rd, block_sector_t sector, void *buffer)
+{
+  memcpy (buffer, sector_address (rd, sector), BLOCK_SECTOR_SIZE);
+}
+
+/* Writes sector SECTOR to RAM disk RD from BUFFER, which must
+   contain BLOCK_SECTOR_SIZE bytes. */
+static void
+ramdisk_write (void *rd, block_sector_t sector, const void *buffer)
+{
+  memcpy (sector_address (rd, sector), buffer, BLOCK_SECTOR_SIZE);
+}
+
+static struct block_operations ramdisk_operations =
+  {
+    ramdisk_read,
+    ramdisk_write,
+    NULL
+  };
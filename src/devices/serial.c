@@ -37,6 +37,16 @@
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable receive and transmit FIFOs. */
+#define FCR_CLEAR 0x06          /* Clear both FIFOs. */
+
+/* Interrupt Identification Register bits. */
+#define IIR_FIFO 0xc0           /* Both set if FIFOs are enabled. */
+
+/* Bytes in the 16550A's transmit FIFO. */
+#define TX_FIFO_SIZE 16
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03            /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80           /* Divisor Latch Access Bit (DLAB). */
@@ -54,6 +64,11 @@ static enum { UNINIT, POLL, QUEUE } mode;
 /* Data to be transmitted. */
 static struct intq txq;
 
+/* Number of bytes the transmitter accepts at once when it
+   reports that it is empty: TX_FIFO_SIZE if the FIFOs are
+   enabled, otherwise 1. */
+static int tx_burst = 1;
+
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
@@ -87,6 +102,14 @@ serial_init_queue (void)
     init_poll ();
   ASSERT (mode == POLL);
 
+  /* Turn on the FIFOs, so that each transmit interrupt can
+     send a burst of bytes instead of just one.  The receive
+     FIFO interrupts on every byte, which keeps keyboard input
+     responsive. */
+  outb (FCR_REG, FCR_ENABLE | FCR_CLEAR);
+  if ((inb (IIR_REG) & IIR_FIFO) == IIR_FIFO)
+    tx_burst = TX_FIFO_SIZE;
+
   intr_register_ext (0x20 + 4, serial_interrupt, "serial");
   mode = QUEUE;
   old_level = intr_disable ();
@@ -129,6 +152,50 @@ serial_putc (uint8_t byte)
   intr_set_level (old_level);
 }
 
+/* Sends the N bytes in BUFFER to the serial port.  Equivalent to
+   calling serial_putc() on each byte, but with interrupts
+   disabled only once for the whole buffer, except while waiting
+   for the transmit queue to drain. */
+void
+serial_putbuf (const uint8_t *buffer, size_t n) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (mode != QUEUE)
+    {
+      if (mode == UNINIT)
+        init_poll ();
+      while (n-- > 0)
+        putc_poll (*buffer++);
+    }
+  else 
+    {
+      while (n-- > 0) 
+        {
+          if (intq_full (&txq)) 
+            {
+              if (old_level == INTR_OFF) 
+                {
+                  /* As in serial_putc(), don't wait with
+                     interrupts off: send a byte by polling. */
+                  putc_poll (intq_getc (&txq)); 
+                }
+              else
+                {
+                  /* Make sure the transmit interrupt is on
+                     before intq_putc() sleeps waiting for it to
+                     make room. */
+                  write_ier ();
+                }
+            }
+          intq_putc (&txq, *buffer++);
+        }
+      write_ier ();
+    }
+
+  intr_set_level (old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void
@@ -218,10 +285,15 @@ serial_interrupt (struct intr_frame *f UNUSED)
   while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
     input_putc (inb (RBR_REG));
 
-  /* As long as we have a byte to transmit, and the hardware is
-     ready to accept a byte for transmission, transmit a byte. */
-  while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
-    outb (THR_REG, intq_getc (&txq));
+  /* If the hardware is ready to accept bytes for transmission,
+     fill its FIFO from the bytes we have to transmit. */
+  if (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0) 
+    {
+      int i;
+
+      for (i = 0; i < tx_burst && !intq_empty (&txq); i++)
+        outb (THR_REG, intq_getc (&txq));
+    }
 
   /* Update interrupt enable register based on queue status. */
   write_ier ();
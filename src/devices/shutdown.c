@@ -4,14 +4,18 @@
 #include "devices/kbd.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
+#include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #endif
 
 /* Keyboard control register port. */
@@ -91,7 +95,13 @@ shutdown_power_off (void)
   const char *p;
 
 #ifdef FILESYS
-  filesys_done ();
+  /* After a kernel panic, interrupts are off and disk state is
+     suspect, so don't try to write anything back. */
+  if (intr_get_level () == INTR_ON)
+    {
+      filesys_done ();
+      block_flush_all ();
+    }
 #endif
 
   print_stats ();
@@ -122,10 +132,13 @@ print_stats (void)
   thread_print_stats ();
 #ifdef FILESYS
   block_print_stats ();
+  inode_print_stats ();
 #endif
   console_print_stats ();
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  process_print_stats ();
+  syscall_print_stats ();
 #endif
 }
@@ -1,4 +1,5 @@
 #include "devices/vga.h"
+#include <debug.h>
 #include <round.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -26,6 +27,7 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+static void put_char (int c, enum intr_level old_level);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -56,7 +58,45 @@ vga_putc (int c)
   enum intr_level old_level = intr_disable ();
 
   init ();
-  
+  put_char (c, old_level);
+  move_cursor ();
+
+  intr_set_level (old_level);
+}
+
+/* Most characters vga_putbuf() writes with interrupts off. */
+#define PUTBUF_BURST 256
+
+/* Writes the N characters in BUFFER to the VGA text display,
+   like calling vga_putc() on each one, but moves the hardware
+   cursor only once per burst of PUTBUF_BURST characters. */
+void
+vga_putbuf (const char *buffer, size_t n) 
+{
+  while (n > 0) 
+    {
+      size_t burst = n < PUTBUF_BURST ? n : PUTBUF_BURST;
+      enum intr_level old_level = intr_disable ();
+
+      init ();
+      n -= burst;
+      while (burst-- > 0)
+        put_char (*buffer++, old_level);
+      move_cursor ();
+
+      intr_set_level (old_level);
+    }
+}
+
+/* Writes C to the framebuffer, interpreting control characters
+   in the conventional ways, but does not move the hardware
+   cursor.  Interrupts must be off.  OLD_LEVEL is the interrupt
+   level to restore while sounding the speaker. */
+static void
+put_char (int c, enum intr_level old_level) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
   switch (c) 
     {
     case '\n':
@@ -95,11 +135,6 @@ vga_putc (int c)
         newline ();
       break;
     }
-
-  /* Update cursor position. */
-  move_cursor ();
-
-  intr_set_level (old_level);
 }
 
 /* Clears the screen and moves the cursor to the upper left. */
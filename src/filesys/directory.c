@@ -5,8 +5,14 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
-/* A directory. */
+/* A directory.
+
+   Each directory inode's dir_lock serializes changes to its
+   entries: dir_add() and dir_remove() hold it for writing, and
+   lookups and reads hold it for reading, so that they proceed in
+   parallel with each other. */
 struct dir 
   {
     struct inode *inode;                /* Backing store. */
@@ -37,6 +43,7 @@ dir_open (struct inode *inode)
   struct dir *dir = calloc (1, sizeof *dir);
   if (inode != NULL && dir != NULL)
     {
+      inode_mark_metadata (inode);
       dir->inode = inode;
       dir->pos = 0;
       return dir;
@@ -124,10 +131,14 @@ dir_lookup (const struct dir *dir, const char *name,
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  /* Open the inode before releasing the lock, so that the entry
+     cannot be removed and its inode freed in between. */
+  rwlock_acquire_read (inode_dir_lock (dir->inode));
   if (lookup (dir, name, &e, NULL))
     *inode = inode_open (e.inode_sector);
   else
     *inode = NULL;
+  rwlock_release_read (inode_dir_lock (dir->inode));
 
   return *inode != NULL;
 }
@@ -152,6 +163,8 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   if (*name == '\0' || strlen (name) > NAME_MAX)
     return false;
 
+  rwlock_acquire_write (inode_dir_lock (dir->inode));
+
   /* Check that NAME is not in use. */
   if (lookup (dir, name, NULL, NULL))
     goto done;
@@ -175,6 +188,7 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
  done:
+  rwlock_release_write (inode_dir_lock (dir->inode));
   return success;
 }
 
@@ -192,6 +206,8 @@ dir_remove (struct dir *dir, const char *name)
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  rwlock_acquire_write (inode_dir_lock (dir->inode));
+
   /* Find directory entry. */
   if (!lookup (dir, name, &e, &ofs))
     goto done;
@@ -211,6 +227,7 @@ dir_remove (struct dir *dir, const char *name)
   success = true;
 
  done:
+  rwlock_release_write (inode_dir_lock (dir->inode));
   inode_close (inode);
   return success;
 }
@@ -222,15 +239,19 @@ bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
 {
   struct dir_entry e;
+  bool found = false;
 
+  rwlock_acquire_read (inode_dir_lock (dir->inode));
   while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) 
     {
       dir->pos += sizeof e;
       if (e.in_use)
         {
           strlcpy (name, e.name, NAME_MAX + 1);
-          return true;
+          found = true;
+          break;
         } 
     }
-  return false;
+  rwlock_release_read (inode_dir_lock (dir->inode));
+  return found;
 }
@@ -6,6 +6,10 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/journal.h"
+#ifdef USERPROG
+#include "userprog/image.h"
+#endif
 
 /* Partition that contains the file system. */
 struct block *fs_device;
@@ -23,6 +27,7 @@ filesys_init (bool format)
 
   inode_init ();
   free_map_init ();
+  journal_init (format);
 
   if (format) 
     do_format ();
@@ -35,6 +40,9 @@ filesys_init (bool format)
 void
 filesys_done (void) 
 {
+#ifdef USERPROG
+  image_done ();
+#endif
   free_map_close ();
 }
 
@@ -46,14 +54,19 @@ bool
 filesys_create (const char *name, off_t initial_size) 
 {
   block_sector_t inode_sector = 0;
-  struct dir *dir = dir_open_root ();
-  bool success = (dir != NULL
-                  && free_map_allocate (1, &inode_sector)
-                  && inode_create (inode_sector, initial_size)
-                  && dir_add (dir, name, inode_sector));
+  struct dir *dir;
+  bool success;
+
+  journal_begin ();
+  dir = dir_open_root ();
+  success = (dir != NULL
+             && free_map_allocate (1, &inode_sector)
+             && inode_create (inode_sector, initial_size)
+             && dir_add (dir, name, inode_sector));
   if (!success && inode_sector != 0) 
     free_map_release (inode_sector, 1);
   dir_close (dir);
+  journal_end ();
 
   return success;
 }
@@ -83,9 +96,14 @@ filesys_open (const char *name)
 bool
 filesys_remove (const char *name) 
 {
-  struct dir *dir = dir_open_root ();
-  bool success = dir != NULL && dir_remove (dir, name);
+  struct dir *dir;
+  bool success;
+
+  journal_begin ();
+  dir = dir_open_root ();
+  success = dir != NULL && dir_remove (dir, name);
   dir_close (dir); 
+  journal_end ();
 
   return success;
 }
@@ -96,8 +114,10 @@ do_format (void)
 {
   printf ("Formatting file system...");
   free_map_create ();
+  journal_begin ();
   if (!dir_create (ROOT_DIR_SECTOR, 16))
     PANIC ("root directory creation failed");
+  journal_end ();
   free_map_close ();
   printf ("done.\n");
 }
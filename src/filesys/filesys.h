@@ -8,6 +8,10 @@
 #define FREE_MAP_SECTOR 0       /* Free map file inode sector. */
 #define ROOT_DIR_SECTOR 1       /* Root directory file inode sector. */
 
+/* Reserved sectors for the metadata journal. */
+#define JOURNAL_SECTOR 2        /* First journal sector. */
+#define JOURNAL_SECTORS 64      /* Number of journal sectors. */
+
 /* Block device that contains the file system. */
 struct block *fs_device;
 
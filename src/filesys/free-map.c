@@ -1,12 +1,51 @@
 #include "filesys/free-map.h"
 #include <bitmap.h>
 #include <debug.h>
+#include <limits.h>
+#include <round.h>
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "threads/synch.h"
+
+/* Number of free map bits stored in each sector of the free map
+   file. */
+#define BITS_PER_SECTOR (BLOCK_SECTOR_SIZE * CHAR_BIT)
+
+/* Number of allocation size classes.  Class K holds requests for
+   2**K through 2**(K+1) - 1 sectors; the last class also holds
+   all larger requests. */
+#define SIZE_CLASS_CNT 16
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per sector. */
+static struct bitmap *dirty_map;     /* Free map file sectors to write. */
+
+/* Protects free_map, dirty_map, and hints[].  Held while dirty
+   parts of the free map are written back, so that they reach the
+   free map file in the order they were made. */
+static struct lock free_map_lock;
+
+/* Where to start searching for free space, per size class.
+   Allocations pick up where the last allocation of the same
+   class left off ("next fit"), rather than rescanning from
+   sector 0, and releases pull the hints of the classes that
+   could use the freed space back to it. */
+static block_sector_t hints[SIZE_CLASS_CNT];
+
+static void mark_dirty (block_sector_t, size_t cnt);
+static bool sync_dirty (void);
+
+/* Returns the size class for an allocation of CNT sectors. */
+static int
+size_class (size_t cnt) 
+{
+  int k = 0;
+  while (cnt >>= 1)
+    k++;
+  return k < SIZE_CLASS_CNT ? k : SIZE_CLASS_CNT - 1;
+}
 
 /* Initializes the free map. */
 void
@@ -15,28 +54,46 @@ free_map_init (void)
   free_map = bitmap_create (block_size (fs_device));
   if (free_map == NULL)
     PANIC ("bitmap creation failed--file system device is too large");
+  dirty_map = bitmap_create (DIV_ROUND_UP (bitmap_file_size (free_map),
+                                           BLOCK_SECTOR_SIZE));
+  if (dirty_map == NULL)
+    PANIC ("dirty map creation failed");
   bitmap_mark (free_map, FREE_MAP_SECTOR);
   bitmap_mark (free_map, ROOT_DIR_SECTOR);
+  bitmap_set_multiple (free_map, JOURNAL_SECTOR, JOURNAL_SECTORS, true);
+  lock_init (&free_map_lock);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
    the first into *SECTORP.
    Returns true if successful, false if not enough consecutive
-   sectors were available or if the free_map file could not be
-   written. */
+   sectors were available or if the free_map file could not be
+   written. */
 bool
 free_map_allocate (size_t cnt, block_sector_t *sectorp)
 {
-  block_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-  if (sector != BITMAP_ERROR
-      && free_map_file != NULL
-      && !bitmap_write (free_map, free_map_file))
+  int k = size_class (cnt);
+  block_sector_t sector;
+
+  lock_acquire (&free_map_lock);
+  sector = bitmap_scan_and_flip (free_map, hints[k], cnt, false);
+  if (sector == BITMAP_ERROR && hints[k] != 0)
+    sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+  if (sector != BITMAP_ERROR)
     {
-      bitmap_set_multiple (free_map, sector, cnt, false); 
-      sector = BITMAP_ERROR;
+      mark_dirty (sector, cnt);
+      if (!sync_dirty ())
+        {
+          bitmap_set_multiple (free_map, sector, cnt, false); 
+          sector = BITMAP_ERROR;
+        }
     }
   if (sector != BITMAP_ERROR)
-    *sectorp = sector;
+    {
+      hints[k] = sector + cnt;
+      *sectorp = sector;
+    }
+  lock_release (&free_map_lock);
   return sector != BITMAP_ERROR;
 }
 
@@ -44,9 +101,51 @@ free_map_allocate (size_t cnt, block_sector_t *sectorp)
 void
 free_map_release (block_sector_t sector, size_t cnt)
 {
+  int k;
+
+  lock_acquire (&free_map_lock);
   ASSERT (bitmap_all (free_map, sector, cnt));
   bitmap_set_multiple (free_map, sector, cnt, false);
-  bitmap_write (free_map, free_map_file);
+  mark_dirty (sector, cnt);
+  sync_dirty ();
+
+  for (k = 0; k <= size_class (cnt); k++)
+    if (hints[k] > sector)
+      hints[k] = sector;
+  lock_release (&free_map_lock);
+}
+
+/* Marks the sectors of the free map file that hold the bits for
+   the CNT sectors starting at SECTOR as needing to be written. */
+static void
+mark_dirty (block_sector_t sector, size_t cnt) 
+{
+  if (cnt > 0)
+    {
+      size_t first = sector / BITS_PER_SECTOR;
+      size_t last = (sector + cnt - 1) / BITS_PER_SECTOR;
+      bitmap_set_multiple (dirty_map, first, last - first + 1, true);
+    }
+}
+
+/* Writes the dirty sectors of the free map to the free map file,
+   if it is open.  Returns true if successful, false otherwise. */
+static bool
+sync_dirty (void) 
+{
+  size_t idx;
+
+  if (free_map_file == NULL)
+    return true;
+
+  while ((idx = bitmap_scan (dirty_map, 0, 1, true)) != BITMAP_ERROR)
+    {
+      if (!bitmap_write_bytes (free_map, free_map_file,
+                               idx * BLOCK_SECTOR_SIZE, BLOCK_SECTOR_SIZE))
+        return false;
+      bitmap_reset (dirty_map, idx);
+    }
+  return true;
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -56,14 +155,22 @@ free_map_open (void)
   free_map_file = file_open (inode_open (FREE_MAP_SECTOR));
   if (free_map_file == NULL)
     PANIC ("can't open free map");
+  inode_mark_metadata (file_get_inode (free_map_file));
   if (!bitmap_read (free_map, free_map_file))
     PANIC ("can't read free map");
+  bitmap_set_all (dirty_map, false);
 }
 
-/* Writes the free map to disk and closes the free map file. */
+/* Writes any unwritten part of the free map to disk and closes
+   the free map file. */
 void
 free_map_close (void) 
 {
+  journal_begin ();
+  lock_acquire (&free_map_lock);
+  sync_dirty ();
+  lock_release (&free_map_lock);
+  journal_end ();
   file_close (free_map_file);
 }
 
@@ -72,6 +179,8 @@ free_map_close (void)
 void
 free_map_create (void) 
 {
+  journal_begin ();
+
   /* Create inode. */
   if (!inode_create (FREE_MAP_SECTOR, bitmap_file_size (free_map)))
     PANIC ("free map creation failed");
@@ -80,6 +189,10 @@ free_map_create (void)
   free_map_file = file_open (inode_open (FREE_MAP_SECTOR));
   if (free_map_file == NULL)
     PANIC ("can't open free map");
+  inode_mark_metadata (file_get_inode (free_map_file));
   if (!bitmap_write (free_map, free_map_file))
     PANIC ("can't write free map");
+  bitmap_set_all (dirty_map, false);
+
+  journal_end ();
 }
@@ -2,10 +2,17 @@
 #include <list.h>
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/journal.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#ifdef USERPROG
+#include "userprog/image.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -28,7 +35,14 @@ bytes_to_sectors (off_t size)
   return DIV_ROUND_UP (size, BLOCK_SECTOR_SIZE);
 }
 
-/* In-memory inode. */
+/* In-memory inode.
+
+   ELEM, OPEN_CNT and REMOVED are protected by open_inodes_lock.
+   RWLOCK protects DATA, DENY_WRITE_CNT, and VERSION: readers of the
+   inode's contents hold it for reading, so that they proceed in
+   parallel, and writers hold it for writing, as does
+   inode_open() while it reads the inode in.  DIR_LOCK is used
+   only if the inode is a directory, by directory.c. */
 struct inode 
   {
     struct list_elem elem;              /* Element in inode list. */
@@ -36,6 +50,11 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    bool metadata;                      /* Journal writes to contents? */
+    unsigned version;                   /* Incremented by each write. */
+    unsigned reader_cnt;                /* Threads in inode_read_at(). */
+    struct rwlock rwlock;               /* Protects contents and length. */
+    struct rwlock dir_lock;             /* Protects directory entries. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -57,11 +76,26 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Protects open_inodes and the open counts of its members. */
+static struct lock open_inodes_lock;
+
+/* Inode I/O statistics, updated with interrupts off.  The peaks
+   show how far reads and writes of inodes overlap. */
+static unsigned read_cnt;               /* Calls to inode_read_at(). */
+static unsigned write_cnt;              /* Calls to inode_write_at(). */
+static unsigned io_cnt;                 /* Threads reading or writing now. */
+static unsigned max_io_cnt;             /* Peak of io_cnt. */
+static unsigned max_reader_cnt;         /* Peak reader_cnt of any inode. */
+
+static void begin_io (struct inode *, bool reading);
+static void end_io (struct inode *, bool reading);
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -89,15 +123,15 @@ inode_create (block_sector_t sector, off_t length)
       disk_inode->magic = INODE_MAGIC;
       if (free_map_allocate (sectors, &disk_inode->start)) 
         {
-          block_write (fs_device, sector, disk_inode);
           if (sectors > 0) 
             {
               static char zeros[BLOCK_SECTOR_SIZE];
               size_t i;
               
               for (i = 0; i < sectors; i++) 
-                block_write (fs_device, disk_inode->start + i, zeros);
+                journal_write_data (disk_inode->start + i, zeros);
             }
+          journal_write (sector, disk_inode);
           success = true; 
         } 
       free (disk_inode);
@@ -114,30 +148,51 @@ inode_open (block_sector_t sector)
   struct list_elem *e;
   struct inode *inode;
 
-  /* Check whether this inode is already open. */
+  lock_acquire (&open_inodes_lock);
+
+  /* Check whether this inode is already open.  If so, wait for
+     whoever opened it first to finish reading it in. */
   for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
        e = list_next (e)) 
     {
       inode = list_entry (e, struct inode, elem);
       if (inode->sector == sector) 
         {
-          inode_reopen (inode);
-          return inode; 
+          inode->open_cnt++;
+          lock_release (&open_inodes_lock);
+          rwlock_acquire_read (&inode->rwlock);
+          rwlock_release_read (&inode->rwlock);
+          return inode;
         }
     }
 
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL)
-    return NULL;
+    {
+      lock_release (&open_inodes_lock);
+      return NULL;
+    }
 
-  /* Initialize. */
+  /* Initialize.  The inode is published before it is read, so
+     that the read does not hold up other opens and closes, but
+     with its rwlock held for writing, so that no one else can use
+     it half-built. */
   list_push_front (&open_inodes, &inode->elem);
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
-  block_read (fs_device, inode->sector, &inode->data);
+  inode->metadata = false;
+  inode->version = 0;
+  inode->reader_cnt = 0;
+  rwlock_init (&inode->rwlock);
+  rwlock_init (&inode->dir_lock);
+  rwlock_acquire_write (&inode->rwlock);
+  lock_release (&open_inodes_lock);
+
+  journal_read (inode->sector, &inode->data);
+  rwlock_release_write (&inode->rwlock);
   return inode;
 }
 
@@ -145,8 +200,12 @@ inode_open (block_sector_t sector)
 struct inode *
 inode_reopen (struct inode *inode)
 {
-  if (inode != NULL)
-    inode->open_cnt++;
+  if (inode != NULL) 
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -163,35 +222,73 @@ inode_get_inumber (const struct inode *inode)
 void
 inode_close (struct inode *inode) 
 {
+  bool last;
+
   /* Ignore null pointer. */
   if (inode == NULL)
     return;
 
   /* Release resources if this was the last opener. */
-  if (--inode->open_cnt == 0)
+  lock_acquire (&open_inodes_lock);
+  last = --inode->open_cnt == 0;
+  if (last)
+    list_remove (&inode->elem);
+  lock_release (&open_inodes_lock);
+
+  if (last)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
- 
-      /* Deallocate blocks if removed. */
+      /* Deallocate blocks if removed, as one journal operation:
+         no file system lock is held here, so it is safe to wait
+         for room in the journal. */
       if (inode->removed) 
         {
+          journal_begin ();
           free_map_release (inode->sector, 1);
           free_map_release (inode->data.start,
                             bytes_to_sectors (inode->data.length)); 
+          journal_end ();
         }
 
       free (inode); 
     }
 }
 
+/* Marks INODE as holding file system metadata, such as a
+   directory or the free map, so that writes to its contents are
+   journaled. */
+void
+inode_mark_metadata (struct inode *inode) 
+{
+  ASSERT (inode != NULL);
+  rwlock_acquire_write (&inode->rwlock);
+  inode->metadata = true;
+  rwlock_release_write (&inode->rwlock);
+}
+
+/* Writes BUFFER to SECTOR, which holds part of INODE's
+   contents. */
+static void
+write_contents (const struct inode *inode, block_sector_t sector,
+                const void *buffer) 
+{
+  if (inode->metadata)
+    journal_write (sector, buffer);
+  else
+    journal_write_data (sector, buffer);
+}
+
 /* Marks INODE to be deleted when it is closed by the last caller who
    has it open. */
 void
 inode_remove (struct inode *inode) 
 {
   ASSERT (inode != NULL);
+  lock_acquire (&open_inodes_lock);
   inode->removed = true;
+  lock_release (&open_inodes_lock);
+#ifdef USERPROG
+  image_invalidate (inode);
+#endif
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -204,6 +301,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
   off_t bytes_read = 0;
   uint8_t *bounce = NULL;
 
+  rwlock_acquire_read (&inode->rwlock);
+  begin_io (inode, true);
   while (size > 0) 
     {
       /* Disk sector to read, starting byte offset within sector. */
@@ -211,7 +310,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       int sector_ofs = offset % BLOCK_SECTOR_SIZE;
 
       /* Bytes left in inode, bytes left in sector, lesser of the two. */
-      off_t inode_left = inode_length (inode) - offset;
+      off_t inode_left = inode->data.length - offset;
       int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
       int min_left = inode_left < sector_left ? inode_left : sector_left;
 
@@ -223,7 +322,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
           /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
+          journal_read (sector_idx, buffer + bytes_read);
         }
       else 
         {
@@ -235,7 +334,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
               if (bounce == NULL)
                 break;
             }
-          block_read (fs_device, sector_idx, bounce);
+          journal_read (sector_idx, bounce);
           memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
         }
       
@@ -244,6 +343,8 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       offset += chunk_size;
       bytes_read += chunk_size;
     }
+  end_io (inode, true);
+  rwlock_release_read (&inode->rwlock);
   free (bounce);
 
   return bytes_read;
@@ -262,8 +363,13 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   off_t bytes_written = 0;
   uint8_t *bounce = NULL;
 
+  /* Writers are exclusive even though files don't grow yet,
+     because partial-sector writes read, modify, and write back
+     whole sectors. */
+  rwlock_acquire_write (&inode->rwlock);
+  begin_io (inode, false);
   if (inode->deny_write_cnt)
-    return 0;
+    size = 0;
 
   while (size > 0) 
     {
@@ -272,7 +378,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       int sector_ofs = offset % BLOCK_SECTOR_SIZE;
 
       /* Bytes left in inode, bytes left in sector, lesser of the two. */
-      off_t inode_left = inode_length (inode) - offset;
+      off_t inode_left = inode->data.length - offset;
       int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
       int min_left = inode_left < sector_left ? inode_left : sector_left;
 
@@ -284,7 +390,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
         {
           /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
+          write_contents (inode, sector_idx, buffer + bytes_written);
         }
       else 
         {
@@ -300,11 +406,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
              we're writing, then we need to read in the sector
              first.  Otherwise we start with a sector of all zeros. */
           if (sector_ofs > 0 || chunk_size < sector_left) 
-            block_read (fs_device, sector_idx, bounce);
+            journal_read (sector_idx, bounce);
           else
             memset (bounce, 0, BLOCK_SECTOR_SIZE);
           memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-          block_write (fs_device, sector_idx, bounce);
+          write_contents (inode, sector_idx, bounce);
         }
 
       /* Advance. */
@@ -312,6 +418,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       offset += chunk_size;
       bytes_written += chunk_size;
     }
+  if (bytes_written > 0)
+    inode->version++;
+  end_io (inode, false);
+  rwlock_release_write (&inode->rwlock);
   free (bounce);
 
   return bytes_written;
@@ -322,8 +432,10 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 void
 inode_deny_write (struct inode *inode) 
 {
+  rwlock_acquire_write (&inode->rwlock);
   inode->deny_write_cnt++;
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+  rwlock_release_write (&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -332,14 +444,92 @@ inode_deny_write (struct inode *inode)
 void
 inode_allow_write (struct inode *inode) 
 {
+  rwlock_acquire_write (&inode->rwlock);
   ASSERT (inode->deny_write_cnt > 0);
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
   inode->deny_write_cnt--;
+  rwlock_release_write (&inode->rwlock);
+}
+
+/* Returns true if INODE has been removed, false otherwise. */
+bool
+inode_is_removed (struct inode *inode) 
+{
+  bool removed;
+
+  lock_acquire (&open_inodes_lock);
+  removed = inode->removed;
+  lock_release (&open_inodes_lock);
+  return removed;
+}
+
+/* Returns INODE's version number, which changes whenever data
+   is written to INODE while it stays open.  Only comparisons
+   between versions of the same open inode are meaningful. */
+unsigned
+inode_version (struct inode *inode)
+{
+  unsigned version;
+
+  rwlock_acquire_read (&inode->rwlock);
+  version = inode->version;
+  rwlock_release_read (&inode->rwlock);
+  return version;
 }
 
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode)
 {
+  /* Files never change size once created, so no lock is
+     needed. */
   return inode->data.length;
 }
+
+/* Returns the lock that directory.c uses to serialize updates to
+   INODE's entries, if INODE is a directory. */
+struct rwlock *
+inode_dir_lock (struct inode *inode) 
+{
+  return &inode->dir_lock;
+}
+
+/* Accounts for the current thread starting to read INODE, if
+   READING is true, or to write it, otherwise. */
+static void
+begin_io (struct inode *inode, bool reading) 
+{
+  enum intr_level old_level = intr_disable ();
+  if (reading) 
+    {
+      read_cnt++;
+      if (++inode->reader_cnt > max_reader_cnt)
+        max_reader_cnt = inode->reader_cnt;
+    }
+  else
+    write_cnt++;
+  if (++io_cnt > max_io_cnt)
+    max_io_cnt = io_cnt;
+  intr_set_level (old_level);
+}
+
+/* Accounts for the current thread finishing the read or write
+   of INODE started by begin_io(). */
+static void
+end_io (struct inode *inode, bool reading) 
+{
+  enum intr_level old_level = intr_disable ();
+  if (reading)
+    inode->reader_cnt--;
+  io_cnt--;
+  intr_set_level (old_level);
+}
+
+/* Prints inode I/O statistics. */
+void
+inode_print_stats (void) 
+{
+  printf ("Inodes: %u reads, %u writes, %u at once, "
+          "%u readers of one inode at once\n",
+          read_cnt, write_cnt, max_io_cnt, max_reader_cnt);
+}
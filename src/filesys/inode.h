@@ -6,6 +6,7 @@
 #include "devices/block.h"
 
 struct bitmap;
+struct rwlock;
 
 void inode_init (void);
 bool inode_create (block_sector_t, off_t);
@@ -14,10 +15,15 @@ struct inode *inode_reopen (struct inode *);
 block_sector_t inode_get_inumber (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
+bool inode_is_removed (struct inode *);
+void inode_mark_metadata (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
+unsigned inode_version (struct inode *);
 off_t inode_length (const struct inode *);
+struct rwlock *inode_dir_lock (struct inode *);
+void inode_print_stats (void);
 
 #endif /* filesys/inode.h */
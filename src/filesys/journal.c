@@ -0,0 +1,435 @@
+#include "filesys/journal.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Write-ahead metadata journal.
+
+   Updates to file system metadata -- the free map, inodes, and
+   directory contents -- are not written to their home locations
+   directly.  Instead, each update is recorded as a full image of
+   the sector being written in the current in-memory transaction.
+   When the transaction commits, all of its images are written
+   to the journal area in one sequential run, followed by a
+   commit record, and only then to their home locations.  If the
+   system crashes part way through the home writes,
+   journal_init() finds the commit record at the next boot and
+   writes the images again ("replays" the journal).  Thus, a
+   multi-sector metadata update such as file creation either
+   happens completely or not at all.
+
+   The journal area occupies JOURNAL_SECTORS sectors starting at
+   JOURNAL_SECTOR:
+
+        descriptor | image 0 | image 1 | ... | image N-1 | commit
+
+   Concurrent operations share a transaction: journal_begin()
+   joins the running transaction, and the transaction commits
+   when the last operation in it calls journal_end().  This
+   "group commit" amortizes the cost of the journal writes across
+   all the operations that overlapped.  Each operation reserves
+   room for OP_IMAGES images when it begins.  Once the running
+   transaction has no room for another operation, new operations
+   wait until the ones in it finish and it commits, so that a
+   transaction never commits while an operation is only part way
+   through it.  Every metadata write must be made within an
+   operation.
+
+   A committing transaction is swapped out of the way, so that
+   its journal and home writes happen without holding the journal
+   lock, while new operations fill the next transaction.  Only
+   one transaction commits at a time.  Reads of sectors that have
+   no image in either transaction, which a bitmap records, do
+   not take the journal lock at all.
+
+   File data is not journaled, but journal_write_data() must be
+   used for data writes so that a sector that is freed as
+   metadata and reused for data before the transaction commits
+   is not overwritten by a stale image. */
+
+/* Identify journal descriptor and commit records. */
+#define DESCRIPTOR_MAGIC 0x4a524e4c
+#define COMMIT_MAGIC 0x434d4954
+
+/* Maximum number of sector images in a transaction. */
+#define MAX_IMAGES (JOURNAL_SECTORS - 2)
+
+/* Maximum number of sectors that one operation may write: a
+   couple each of free map, inode, and directory sectors. */
+#define OP_IMAGES 8
+
+/* Journal descriptor.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_descriptor
+  {
+    unsigned magic;                     /* DESCRIPTOR_MAGIC. */
+    uint32_t seq;                       /* Transaction sequence number. */
+    uint32_t cnt;                       /* Number of images. */
+    block_sector_t sectors[125];        /* Home location of each image. */
+  };
+
+/* Journal commit record.
+   Must be exactly BLOCK_SECTOR_SIZE bytes long. */
+struct journal_commit
+  {
+    unsigned magic;                     /* COMMIT_MAGIC. */
+    uint32_t seq;                       /* Same as descriptor's seq. */
+    uint32_t unused[126];               /* Not used. */
+  };
+
+/* A sector image in a transaction. */
+struct journal_image
+  {
+    block_sector_t sector;              /* Home location. */
+    uint8_t data[BLOCK_SECTOR_SIZE];    /* Contents. */
+  };
+
+/* A transaction. */
+struct transaction
+  {
+    struct journal_image *images;       /* Sector images. */
+    size_t image_cnt;                   /* Number of images. */
+  };
+
+static struct lock journal_lock;        /* Protects all of the below. */
+static struct condition commit_done;    /* Signaled when a commit ends. */
+static struct transaction running;      /* Transaction being filled. */
+static struct transaction committing;   /* Transaction being written. */
+static bool commit_busy;                /* Is `committing' in use? */
+static int active_cnt;                  /* Operations in `running'. */
+static bool full;                       /* Must new operations wait? */
+static uint32_t next_seq;               /* Next sequence number. */
+
+/* Sectors that have an image in `running' or `committing'.
+   Changed only with journal_lock held, but may be tested
+   without it. */
+static struct bitmap *pending;
+
+static void commit (void);
+static void write_descriptor (uint32_t seq, const struct transaction *);
+static void replay (void);
+static struct journal_image *find_image (const struct transaction *,
+                                         block_sector_t);
+static struct journal_image *find_newest_image (block_sector_t);
+
+/* Initializes the journal.  If FORMAT is true, creates an empty
+   journal; otherwise, replays any transaction that committed
+   before the system last stopped. */
+void
+journal_init (bool format) 
+{
+  ASSERT (sizeof (struct journal_descriptor) == BLOCK_SECTOR_SIZE);
+  ASSERT (sizeof (struct journal_commit) == BLOCK_SECTOR_SIZE);
+  ASSERT (MAX_IMAGES <= 125);
+  ASSERT (OP_IMAGES <= MAX_IMAGES);
+
+  lock_init (&journal_lock);
+  cond_init (&commit_done);
+  running.images = malloc (MAX_IMAGES * sizeof *running.images);
+  committing.images = malloc (MAX_IMAGES * sizeof *committing.images);
+  pending = bitmap_create (block_size (fs_device));
+  if (running.images == NULL || committing.images == NULL
+      || pending == NULL)
+    PANIC ("can't allocate journal");
+  running.image_cnt = committing.image_cnt = 0;
+  commit_busy = false;
+  active_cnt = 0;
+  full = false;
+  next_seq = 1;
+
+  if (format)
+    write_descriptor (0, &running);
+  else
+    replay ();
+}
+
+/* Starts a file system operation whose metadata updates must be
+   made atomically.  The operation joins the running transaction,
+   first waiting for it to commit if it has no room for the
+   operation.  Must be paired with a call to journal_end().
+   Nested operations are part of the outermost one.
+
+   Because it may wait for other operations to finish, the
+   outermost journal_begin() of an operation must come before it
+   acquires any file system lock. */
+void
+journal_begin (void) 
+{
+  struct thread *t = thread_current ();
+
+  if (t->journal_depth++ > 0)
+    return;
+
+  lock_acquire (&journal_lock);
+  while (full
+         || running.image_cnt + (active_cnt + 1) * OP_IMAGES > MAX_IMAGES)
+    {
+      full = true;
+      cond_wait (&commit_done, &journal_lock);
+    }
+  active_cnt++;
+  lock_release (&journal_lock);
+}
+
+/* Ends an operation started with journal_begin().  If it was
+   the last operation in the running transaction, commits the
+   transaction. */
+void
+journal_end (void) 
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->journal_depth > 0);
+  if (--t->journal_depth > 0)
+    return;
+
+  lock_acquire (&journal_lock);
+  ASSERT (active_cnt > 0);
+  if (--active_cnt == 0)
+    commit ();
+  lock_release (&journal_lock);
+}
+
+/* Reads SECTOR of the file system device into BUFFER, which
+   must have room for BLOCK_SECTOR_SIZE bytes.  Returns the
+   sector's newest contents, even if they have not yet been
+   committed. */
+void
+journal_read (block_sector_t sector, void *buffer) 
+{
+  struct journal_image *image = NULL;
+
+  if (bitmap_test (pending, sector))
+    {
+      lock_acquire (&journal_lock);
+      image = find_newest_image (sector);
+      if (image != NULL)
+        memcpy (buffer, image->data, BLOCK_SECTOR_SIZE);
+      lock_release (&journal_lock);
+    }
+
+  if (image == NULL)
+    block_read (fs_device, sector, buffer);
+}
+
+/* Records a metadata write of BUFFER, which must contain
+   BLOCK_SECTOR_SIZE bytes, to SECTOR in the running
+   transaction.  Must be called within an operation, because
+   starting one here could wait for a commit while the caller
+   holds file system locks. */
+void
+journal_write (block_sector_t sector, const void *buffer) 
+{
+  struct journal_image *image;
+
+  ASSERT (thread_current ()->journal_depth > 0);
+  lock_acquire (&journal_lock);
+  image = find_image (&running, sector);
+  if (image == NULL)
+    {
+      if (running.image_cnt >= MAX_IMAGES)
+        PANIC ("journal: operations wrote more than %d sectors each",
+               OP_IMAGES);
+      image = &running.images[running.image_cnt++];
+      image->sector = sector;
+      bitmap_mark (pending, sector);
+    }
+  memcpy (image->data, buffer, BLOCK_SECTOR_SIZE);
+  lock_release (&journal_lock);
+}
+
+/* Writes BUFFER, which must contain BLOCK_SECTOR_SIZE bytes, to
+   SECTOR, which holds file data rather than metadata.  The write
+   goes directly to disk, but also replaces any image of SECTOR
+   in the running transaction, and waits out any commit of an
+   older image, so that no image can later overwrite it. */
+void
+journal_write_data (block_sector_t sector, const void *buffer) 
+{
+  if (bitmap_test (pending, sector))
+    {
+      struct journal_image *image;
+
+      lock_acquire (&journal_lock);
+      while (commit_busy && find_image (&committing, sector) != NULL)
+        cond_wait (&commit_done, &journal_lock);
+      image = find_image (&running, sector);
+      if (image != NULL)
+        memcpy (image->data, buffer, BLOCK_SECTOR_SIZE);
+      lock_release (&journal_lock);
+    }
+
+  block_write (fs_device, sector, buffer);
+}
+
+/* Returns the image of SECTOR in transaction TXN, or a null
+   pointer if there is none.  The journal lock must be held. */
+static struct journal_image *
+find_image (const struct transaction *txn, block_sector_t sector) 
+{
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&journal_lock));
+  for (i = 0; i < txn->image_cnt; i++)
+    if (txn->images[i].sector == sector)
+      return &txn->images[i];
+  return NULL;
+}
+
+/* Returns the newest image of SECTOR, in the running transaction
+   or else in the committing one, or a null pointer if there is
+   none.  The journal lock must be held. */
+static struct journal_image *
+find_newest_image (block_sector_t sector) 
+{
+  struct journal_image *image = find_image (&running, sector);
+  if (image == NULL && commit_busy)
+    image = find_image (&committing, sector);
+  return image;
+}
+
+/* Commits the running transaction: writes it to the journal,
+   then to its home locations, then marks the journal empty.
+   The journal lock must be held, and no operation may be active
+   in the running transaction.  The lock is released while the
+   transaction is written. */
+static void
+commit (void) 
+{
+  struct journal_commit *c;
+  struct transaction txn;
+  uint32_t seq;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&journal_lock));
+  ASSERT (active_cnt == 0);
+
+  /* Wait for the previous commit to finish writing the journal
+     area.  Operations may join the running transaction in the
+     meantime, in which case the last of them commits it. */
+  while (commit_busy)
+    {
+      cond_wait (&commit_done, &journal_lock);
+      if (active_cnt > 0)
+        return;
+    }
+
+  /* Swap the running transaction out, making room for new
+     operations. */
+  if (running.image_cnt > 0)
+    {
+      txn = committing;
+      committing = running;
+      running = txn;
+      running.image_cnt = 0;
+      commit_busy = true;
+    }
+  full = false;
+  cond_broadcast (&commit_done, &journal_lock);
+  if (!commit_busy)
+    return;
+  seq = next_seq++;
+  lock_release (&journal_lock);
+
+  /* Write descriptor, images, and commit record, in that order,
+     as one sequential run of sectors. */
+  write_descriptor (seq, &committing);
+  for (i = 0; i < committing.image_cnt; i++)
+    block_write (fs_device, JOURNAL_SECTOR + 1 + i, committing.images[i].data);
+  c = calloc (1, sizeof *c);
+  if (c == NULL)
+    PANIC ("can't allocate journal commit record");
+  c->magic = COMMIT_MAGIC;
+  c->seq = seq;
+  block_write (fs_device, JOURNAL_SECTOR + 1 + committing.image_cnt, c);
+  free (c);
+
+  /* The transaction is now durable.  Checkpoint it. */
+  for (i = 0; i < committing.image_cnt; i++)
+    block_write (fs_device, committing.images[i].sector,
+                 committing.images[i].data);
+  txn.image_cnt = 0;
+  write_descriptor (seq, &txn);
+
+  /* Sectors written home no longer need the journal, unless the
+     running transaction has a newer image of them. */
+  lock_acquire (&journal_lock);
+  for (i = 0; i < committing.image_cnt; i++)
+    {
+      block_sector_t sector = committing.images[i].sector;
+      if (find_image (&running, sector) == NULL)
+        bitmap_reset (pending, sector);
+    }
+  committing.image_cnt = 0;
+  commit_busy = false;
+  cond_broadcast (&commit_done, &journal_lock);
+}
+
+/* Writes a journal descriptor for transaction SEQ, which
+   contains the images in TXN. */
+static void
+write_descriptor (uint32_t seq, const struct transaction *txn) 
+{
+  struct journal_descriptor *d;
+  size_t i;
+
+  d = calloc (1, sizeof *d);
+  if (d == NULL)
+    PANIC ("can't allocate journal descriptor");
+  d->magic = DESCRIPTOR_MAGIC;
+  d->seq = seq;
+  d->cnt = txn->image_cnt;
+  for (i = 0; i < txn->image_cnt; i++)
+    d->sectors[i] = txn->images[i].sector;
+  block_write (fs_device, JOURNAL_SECTOR, d);
+  free (d);
+}
+
+/* Reads the journal and, if it contains a committed transaction
+   that may not have been completely checkpointed, writes the
+   transaction's images to their home locations. */
+static void
+replay (void) 
+{
+  struct journal_descriptor *d;
+  struct journal_commit *c;
+  uint8_t *buffer;
+
+  d = malloc (sizeof *d);
+  c = malloc (sizeof *c);
+  buffer = malloc (BLOCK_SECTOR_SIZE);
+  if (d == NULL || c == NULL || buffer == NULL)
+    PANIC ("can't allocate memory for journal replay");
+
+  block_read (fs_device, JOURNAL_SECTOR, d);
+  if (d->magic != DESCRIPTOR_MAGIC)
+    PANIC ("file system has no journal (reformat with -f)");
+  next_seq = d->seq + 1;
+  if (d->cnt > 0 && d->cnt <= MAX_IMAGES)
+    {
+      block_read (fs_device, JOURNAL_SECTOR + 1 + d->cnt, c);
+      if (c->magic == COMMIT_MAGIC && c->seq == d->seq)
+        {
+          uint32_t i;
+
+          printf ("journal: replaying transaction %"PRIu32
+                  " (%"PRIu32" sectors)\n", d->seq, d->cnt);
+          for (i = 0; i < d->cnt; i++)
+            {
+              block_read (fs_device, JOURNAL_SECTOR + 1 + i, buffer);
+              block_write (fs_device, d->sectors[i], buffer);
+            }
+        }
+      d->cnt = 0;
+      block_write (fs_device, JOURNAL_SECTOR, d);
+    }
+
+  free (buffer);
+  free (c);
+  free (d);
+}
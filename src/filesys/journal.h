@@ -0,0 +1,18 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stdbool.h>
+#include "devices/block.h"
+
+void journal_init (bool format);
+
+/* Transactions. */
+void journal_begin (void);
+void journal_end (void);
+
+/* Sector I/O. */
+void journal_read (block_sector_t, void *);
+void journal_write (block_sector_t, const void *);
+void journal_write_data (block_sector_t, const void *);
+
+#endif /* filesys/journal.h */
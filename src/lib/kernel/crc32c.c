@@ -0,0 +1,79 @@
+#include "crc32c.h"
+#include <debug.h>
+#include <stdbool.h>
+
+/* CRC-32C using the "slice-by-8" technique: eight lookup tables
+   let the inner loop fold in 8 bytes of input per iteration
+   with independent table lookups, instead of one byte at a time
+   as in the classic table-driven algorithm.  See [Kounavis].
+
+   CRC-32C uses the reversed polynomial 0x82f63b78.  The tables
+   occupy 8 kB and are computed by crc32c_init(). */
+
+/* Reversed CRC-32C polynomial. */
+#define POLY 0x82f63b78
+
+/* Lookup tables.
+   table[0] is the usual byte-at-a-time table.
+   table[K][I] is the CRC of byte I followed by K zero bytes. */
+static uint32_t table[8][256];
+static bool initialized;
+
+/* Computes the lookup tables.  Must be called before
+   crc32c(). */
+void
+crc32c_init (void) 
+{
+  unsigned i, j, k;
+
+  if (initialized)
+    return;
+
+  for (i = 0; i < 256; i++) 
+    {
+      uint32_t crc = i;
+      for (j = 0; j < 8; j++)
+        crc = crc & 1 ? (crc >> 1) ^ POLY : crc >> 1;
+      table[0][i] = crc;
+    }
+  for (i = 0; i < 256; i++)
+    for (k = 1; k < 8; k++)
+      table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+  initialized = true;
+}
+
+/* Returns the CRC-32C of the SIZE bytes in BUF. */
+uint32_t
+crc32c (const void *buf_, size_t size) 
+{
+  const uint8_t *buf = buf_;
+  uint32_t crc = 0xffffffff;
+
+  ASSERT (initialized);
+
+  /* Consume bytes until BUF is aligned on a word boundary. */
+  for (; size > 0 && (uintptr_t) buf % sizeof (uint32_t) != 0; size--)
+    crc = table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+  /* Consume 8 bytes at a time.  This relies on the x86 being
+     little-endian. */
+  for (; size >= 8; size -= 8, buf += 8) 
+    {
+      uint32_t lo = *(const uint32_t *) buf ^ crc;
+      uint32_t hi = *(const uint32_t *) (buf + 4);
+      crc = (table[7][lo & 0xff]
+             ^ table[6][(lo >> 8) & 0xff]
+             ^ table[5][(lo >> 16) & 0xff]
+             ^ table[4][lo >> 24]
+             ^ table[3][hi & 0xff]
+             ^ table[2][(hi >> 8) & 0xff]
+             ^ table[1][(hi >> 16) & 0xff]
+             ^ table[0][hi >> 24]);
+    }
+
+  /* Consume any remaining bytes. */
+  for (; size > 0; size--)
+    crc = table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+  return ~crc;
+}
@@ -0,0 +1,11 @@
+#ifndef __LIB_KERNEL_CRC32C_H
+#define __LIB_KERNEL_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* CRC-32C (Castagnoli), as used by iSCSI, SCTP, and ext4. */
+void crc32c_init (void);
+uint32_t crc32c (const void *, size_t);
+
+#endif /* lib/kernel/crc32c.h */
@@ -0,0 +1,61 @@
+/* Child process for syn-mixed test.
+   Children 0 through READER_CNT - 1 read the test's read file a
+   byte at a time, reopening it every 64 bytes, and the last child
+   writes the test's write file a byte at a time, so that reads of
+   one file, writes of another, opens, and closes overlap in the
+   kernel. */
+
+#include <random.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/filesys/base/syn-mixed.h"
+
+const char *test_name = "child-syn-mix";
+
+static char buf[BUF_SIZE];
+
+int
+main (int argc, const char *argv[]) 
+{
+  int child_idx;
+  int fd = -1;
+  size_t i;
+
+  quiet = true;
+  
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+
+  random_init (child_idx < READER_CNT ? 0 : 1);
+  random_bytes (buf, sizeof buf);
+
+  if (child_idx < READER_CNT) 
+    {
+      for (i = 0; i < sizeof buf; i++) 
+        {
+          char c;
+          if (i % 64 == 0)
+            {
+              if (fd > 1)
+                close (fd);
+              CHECK ((fd = open (read_file_name)) > 1, "open \"%s\"",
+                     read_file_name);
+              seek (fd, i);
+            }
+          CHECK (read (fd, &c, 1) > 0, "read \"%s\"", read_file_name);
+          compare_bytes (&c, buf + i, 1, i, read_file_name);
+        }
+    }
+  else
+    {
+      CHECK ((fd = open (write_file_name)) > 1, "open \"%s\"",
+             write_file_name);
+      for (i = 0; i < sizeof buf; i++)
+        CHECK (write (fd, buf + i, 1) > 0, "write \"%s\"", write_file_name);
+    }
+  close (fd);
+
+  return child_idx;
+}
@@ -0,0 +1,42 @@
+/* Spawns child processes that run in parallel: several read the
+   same file a byte at a time, reopening it now and then, while
+   another writes a second file a byte at a time.  Then reads
+   back the second file and verifies its contents.
+
+   syn-mixed.ck checks the kernel's inode statistics to see that
+   the readers were inside the same inode at the same time, and
+   that reads and writes of the two files overlapped. */
+
+#include <random.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/filesys/base/syn-mixed.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[BUF_SIZE];
+
+void
+test_main (void) 
+{
+  pid_t children[CHILD_CNT];
+  int fd;
+
+  CHECK (create (read_file_name, sizeof buf), "create \"%s\"",
+         read_file_name);
+  CHECK ((fd = open (read_file_name)) > 1, "open \"%s\"", read_file_name);
+  random_init (0);
+  random_bytes (buf, sizeof buf);
+  CHECK (write (fd, buf, sizeof buf) > 0, "write \"%s\"", read_file_name);
+  msg ("close \"%s\"", read_file_name);
+  close (fd);
+  CHECK (create (write_file_name, sizeof buf), "create \"%s\"",
+         write_file_name);
+
+  exec_children ("child-syn-mix", children, CHILD_CNT);
+  wait_children (children, CHILD_CNT);
+
+  random_init (1);
+  random_bytes (buf, sizeof buf);
+  check_file (write_file_name, buf, sizeof buf);
+}
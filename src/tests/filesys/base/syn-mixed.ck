@@ -0,0 +1,37 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+
+# Under a global file system lock, only one thread at a time
+# could be inside inode I/O, so the peaks would both be 1.
+my (@output) = read_text_file ("$test.output");
+my ($stats) = grep (/^Inodes: /, @output);
+fail "missing inode statistics\n" if !defined $stats;
+my ($at_once, $readers) = $stats =~ /(\d+) at once, (\d+) readers of one inode at once$/
+  or fail "can't parse \"$stats\"\n";
+fail "readers of one file never overlapped\n" if $readers < 2;
+fail "reads and writes never overlapped\n" if $at_once < 2;
+
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(syn-mixed) begin
+(syn-mixed) create "read-data"
+(syn-mixed) open "read-data"
+(syn-mixed) write "read-data"
+(syn-mixed) close "read-data"
+(syn-mixed) create "write-data"
+(syn-mixed) exec child 1 of 4: "child-syn-mix 0"
+(syn-mixed) exec child 2 of 4: "child-syn-mix 1"
+(syn-mixed) exec child 3 of 4: "child-syn-mix 2"
+(syn-mixed) exec child 4 of 4: "child-syn-mix 3"
+(syn-mixed) wait for child 1 of 4 returned 0 (expected 0)
+(syn-mixed) wait for child 2 of 4 returned 1 (expected 1)
+(syn-mixed) wait for child 3 of 4 returned 2 (expected 2)
+(syn-mixed) wait for child 4 of 4 returned 3 (expected 3)
+(syn-mixed) open "write-data" for verification
+(syn-mixed) verified contents of "write-data"
+(syn-mixed) close "write-data"
+(syn-mixed) end
+EOF
+pass;
@@ -0,0 +1,10 @@
+#ifndef TESTS_FILESYS_BASE_SYN_MIXED_H
+#define TESTS_FILESYS_BASE_SYN_MIXED_H
+
+#define READER_CNT 3
+#define CHILD_CNT (READER_CNT + 1)
+#define BUF_SIZE 1024
+static const char read_file_name[] = "read-data";
+static const char write_file_name[] = "write-data";
+
+#endif /* tests/filesys/base/syn-mixed.h */
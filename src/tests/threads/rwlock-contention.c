@@ -0,0 +1,199 @@
+/* Contention benchmark for locks, readers-writer locks, and
+   sequence locks.
+
+   THREAD_CNT threads share a record of RECORD_CNT integers.  Each
+   thread makes ITER_CNT accesses to it, one in WRITE_RATIO of
+   which increment every integer and the rest of which read them
+   all and check that they are equal.  A reader yields the CPU
+   halfway through each read, as if it had been preempted, so
+   that the other threads contend for the record while the read
+   is in progress.
+
+   The record is protected first by a lock, then by a
+   readers-writer lock, then by a sequence lock, and the test
+   reports the time each protocol takes.  The figures depend on
+   the machine, so only their presence is checked. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define ITER_CNT 500
+#define WRITE_RATIO 10
+#define RECORD_CNT 16
+
+/* How the record is protected. */
+enum protocol
+  {
+    USE_LOCK,
+    USE_RWLOCK,
+    USE_SEQLOCK
+  };
+
+static enum protocol protocol;
+static struct lock lock;
+static struct rwlock rwlock;
+static struct seqlock seqlock;
+static int record[RECORD_CNT];
+static struct semaphore done;
+
+static thread_func contention_thread;
+static void run (enum protocol, const char *name);
+
+void
+test_rwlock_contention (void)
+{
+  lock_init (&lock);
+  rwlock_init (&rwlock);
+  seqlock_init (&seqlock);
+
+  run (USE_LOCK, "lock");
+  run (USE_RWLOCK, "rwlock");
+  run (USE_SEQLOCK, "seqlock");
+}
+
+/* Runs the benchmark with the record protected by PROTOCOL and
+   reports the results under NAME. */
+static void
+run (enum protocol protocol_, const char *name)
+{
+  uint64_t start, cycles;
+  int i;
+
+  protocol = protocol_;
+  sema_init (&done, 0);
+  for (i = 0; i < RECORD_CNT; i++)
+    record[i] = 0;
+
+  start = timer_cycles ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "contender %d", i);
+      thread_create (name, PRI_DEFAULT, contention_thread, NULL);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  cycles = timer_cycles () - start;
+
+  for (i = 0; i < RECORD_CNT; i++)
+    if (record[i] != THREAD_CNT * (ITER_CNT / WRITE_RATIO))
+      fail ("%s: lost update to record[%d]", name, i);
+  msg ("%s: %d accesses in %"PRIu64" cycles (%"PRIu64" per access)",
+       name, THREAD_CNT * ITER_CNT, cycles,
+       cycles / (THREAD_CNT * ITER_CNT));
+}
+
+/* Copies integers START through END - 1 of the record into
+   COPY. */
+static void
+copy_record (int copy[], int start, int end)
+{
+  int i;
+
+  for (i = start; i < end; i++)
+    copy[i] = record[i];
+}
+
+/* Reads the record under the current protocol and checks that it
+   is consistent. */
+static void
+read_record (void)
+{
+  int copy[RECORD_CNT];
+  int i;
+
+  switch (protocol)
+    {
+    case USE_LOCK:
+      lock_acquire (&lock);
+      copy_record (copy, 0, RECORD_CNT / 2);
+      thread_yield ();
+      copy_record (copy, RECORD_CNT / 2, RECORD_CNT);
+      lock_release (&lock);
+      break;
+
+    case USE_RWLOCK:
+      rwlock_acquire_read (&rwlock);
+      copy_record (copy, 0, RECORD_CNT / 2);
+      thread_yield ();
+      copy_record (copy, RECORD_CNT / 2, RECORD_CNT);
+      rwlock_release_read (&rwlock);
+      break;
+
+    case USE_SEQLOCK:
+      {
+        unsigned seq;
+        bool yielded = false;
+
+        do
+          {
+            seq = seqlock_read_begin (&seqlock);
+            copy_record (copy, 0, RECORD_CNT / 2);
+            if (!yielded)
+              {
+                thread_yield ();
+                yielded = true;
+              }
+            copy_record (copy, RECORD_CNT / 2, RECORD_CNT);
+          }
+        while (seqlock_read_retry (&seqlock, seq));
+      }
+      break;
+    }
+
+  for (i = 1; i < RECORD_CNT; i++)
+    if (copy[i] != copy[0])
+      fail ("inconsistent read: record[%d]=%d but record[0]=%d",
+            i, copy[i], copy[0]);
+}
+
+/* Increments every integer in the record under the current
+   protocol. */
+static void
+write_record (void)
+{
+  int i;
+
+  switch (protocol)
+    {
+    case USE_LOCK:
+      lock_acquire (&lock);
+      for (i = 0; i < RECORD_CNT; i++)
+        record[i]++;
+      lock_release (&lock);
+      break;
+
+    case USE_RWLOCK:
+      rwlock_acquire_write (&rwlock);
+      for (i = 0; i < RECORD_CNT; i++)
+        record[i]++;
+      rwlock_release_write (&rwlock);
+      break;
+
+    case USE_SEQLOCK:
+      seqlock_write_begin (&seqlock);
+      for (i = 0; i < RECORD_CNT; i++)
+        record[i]++;
+      seqlock_write_end (&seqlock);
+      break;
+    }
+}
+
+static void
+contention_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    if (i % WRITE_RATIO == 0)
+      write_record ();
+    else
+      read_record ();
+  sema_up (&done);
+}
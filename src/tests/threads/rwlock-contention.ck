@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# The timings vary from run to run, so check only that each
+# protocol reports them.
+foreach my $protocol (qw (lock rwlock seqlock)) {
+    fail "missing result for $protocol\n"
+      if !grep (/^\(rwlock-contention\) $protocol: 4000 accesses in \d+ cycles/,
+		@output);
+}
+pass;
@@ -0,0 +1,58 @@
+/* Checks that two readers can hold a readers-writer lock at the
+   same time, that a writer waits for the readers to leave, and
+   that a reader that arrives while a writer is waiting queues up
+   behind the writer instead of joining the readers. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func reader_thread;
+static thread_func writer_thread;
+static struct rwlock rwlock;
+static struct semaphore done;
+
+void
+test_rwlock_prefer (void)
+{
+  rwlock_init (&rwlock);
+  sema_init (&done, 0);
+
+  rwlock_acquire_read (&rwlock);
+  msg ("Main thread holds the lock for reading.");
+
+  /* Another reader gets in right away. */
+  thread_create ("reader 1", PRI_DEFAULT, reader_thread, NULL);
+  sema_down (&done);
+
+  /* A writer has to wait, and so does a reader behind it. */
+  thread_create ("writer", PRI_DEFAULT, writer_thread, NULL);
+  thread_create ("reader 2", PRI_DEFAULT, reader_thread, NULL);
+  timer_sleep (10);
+
+  msg ("Main thread releasing the lock.");
+  rwlock_release_read (&rwlock);
+  sema_down (&done);
+  sema_down (&done);
+}
+
+static void
+reader_thread (void *aux UNUSED)
+{
+  rwlock_acquire_read (&rwlock);
+  msg ("%s acquired the lock for reading.", thread_name ());
+  rwlock_release_read (&rwlock);
+  sema_up (&done);
+}
+
+static void
+writer_thread (void *aux UNUSED)
+{
+  rwlock_acquire_write (&rwlock);
+  msg ("%s acquired the lock for writing.", thread_name ());
+  rwlock_release_write (&rwlock);
+  sema_up (&done);
+}
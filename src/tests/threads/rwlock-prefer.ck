@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-prefer) begin
+(rwlock-prefer) Main thread holds the lock for reading.
+(rwlock-prefer) reader 1 acquired the lock for reading.
+(rwlock-prefer) Main thread releasing the lock.
+(rwlock-prefer) writer acquired the lock for writing.
+(rwlock-prefer) reader 2 acquired the lock for reading.
+(rwlock-prefer) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Tests that, of the writers waiting for a readers-writer lock,
+   the one with the highest priority gets it first. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func rwlock_priority_thread;
+static struct rwlock rwlock;
+static struct semaphore done;
+
+void
+test_rwlock_priority (void)
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rwlock_init (&rwlock);
+  sema_init (&done, 0);
+
+  rwlock_acquire_write (&rwlock);
+  for (i = 0; i < 10; i++)
+    {
+      int priority = PRI_DEFAULT - (i + 3) % 10 - 1;
+      char name[16];
+      snprintf (name, sizeof name, "priority %d", priority);
+      thread_create (name, priority, rwlock_priority_thread, NULL);
+    }
+
+  /* Let all of the writers start waiting. */
+  timer_sleep (10);
+  msg ("Main thread releasing the lock.");
+  rwlock_release_write (&rwlock);
+
+  for (i = 0; i < 10; i++)
+    sema_down (&done);
+}
+
+static void
+rwlock_priority_thread (void *aux UNUSED)
+{
+  rwlock_acquire_write (&rwlock);
+  msg ("Thread %s acquired the lock.", thread_name ());
+  rwlock_release_write (&rwlock);
+  sema_up (&done);
+}
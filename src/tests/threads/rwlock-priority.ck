@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-priority) begin
+(rwlock-priority) Main thread releasing the lock.
+(rwlock-priority) Thread priority 30 acquired the lock.
+(rwlock-priority) Thread priority 29 acquired the lock.
+(rwlock-priority) Thread priority 28 acquired the lock.
+(rwlock-priority) Thread priority 27 acquired the lock.
+(rwlock-priority) Thread priority 26 acquired the lock.
+(rwlock-priority) Thread priority 25 acquired the lock.
+(rwlock-priority) Thread priority 24 acquired the lock.
+(rwlock-priority) Thread priority 23 acquired the lock.
+(rwlock-priority) Thread priority 22 acquired the lock.
+(rwlock-priority) Thread priority 21 acquired the lock.
+(rwlock-priority) end
+EOF
+pass;
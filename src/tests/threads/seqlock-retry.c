@@ -0,0 +1,65 @@
+/* Checks that a sequence lock reader notices a write that
+   happens in the middle of its read, and that its retry sees a
+   consistent record. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread;
+static struct seqlock seqlock;
+static struct semaphore go, done;
+static int x, y;
+
+void
+test_seqlock_retry (void)
+{
+  int i;
+
+  seqlock_init (&seqlock);
+  sema_init (&go, 0);
+  sema_init (&done, 0);
+  thread_create ("writer", PRI_DEFAULT, writer_thread, NULL);
+
+  for (i = 0; i < 3; i++)
+    {
+      unsigned seq;
+      int tries = 0;
+      int a, b;
+
+      do
+        {
+          seq = seqlock_read_begin (&seqlock);
+          a = x;
+          if (tries++ == 0)
+            {
+              /* Have the writer update the record between our
+                 reads of X and Y. */
+              sema_up (&go);
+              sema_down (&done);
+            }
+          b = y;
+        }
+      while (seqlock_read_retry (&seqlock, seq));
+
+      msg ("Read x=%d, y=%d in %d tries.", a, b, tries);
+    }
+}
+
+static void
+writer_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    {
+      sema_down (&go);
+      seqlock_write_begin (&seqlock);
+      x++;
+      y++;
+      seqlock_write_end (&seqlock);
+      sema_up (&done);
+    }
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(seqlock-retry) begin
+(seqlock-retry) Read x=1, y=1 in 2 tries.
+(seqlock-retry) Read x=2, y=2 in 2 tries.
+(seqlock-retry) Read x=3, y=3 in 2 tries.
+(seqlock-retry) end
+EOF
+pass;
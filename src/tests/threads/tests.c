@@ -31,6 +31,10 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"rwlock-prefer", test_rwlock_prefer},
+    {"rwlock-priority", test_rwlock_priority},
+    {"rwlock-contention", test_rwlock_contention},
+    {"seqlock-retry", test_seqlock_retry},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
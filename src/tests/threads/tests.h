@@ -25,6 +25,10 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_rwlock_prefer;
+extern test_func test_rwlock_priority;
+extern test_func test_rwlock_contention;
+extern test_func test_seqlock_retry;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
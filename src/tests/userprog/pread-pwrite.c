@@ -0,0 +1,44 @@
+/* Writes the sample with pwrite() in two pieces, second piece
+   first, and reads it back with pread(), checking that neither
+   call uses or moves the file position. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  size_t half = size / 2;
+  char buf[sizeof sample];
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = pwrite (handle, sample + half, size - half, half);
+  if (byte_cnt != (int) (size - half))
+    fail ("pwrite() returned %d instead of %zu", byte_cnt, size - half);
+  byte_cnt = pwrite (handle, sample, half, 0);
+  if (byte_cnt != (int) half)
+    fail ("pwrite() returned %d instead of %zu", byte_cnt, half);
+  if (tell (handle) != 0)
+    fail ("pwrite() moved file position to %u", tell (handle));
+
+  byte_cnt = pread (handle, buf, size, 0);
+  if (byte_cnt != (int) size)
+    fail ("pread() returned %d instead of %zu", byte_cnt, size);
+  compare_bytes (buf, sample, size, 0, "test.txt");
+  if (tell (handle) != 0)
+    fail ("pread() moved file position to %u", tell (handle));
+
+  byte_cnt = pread (handle, buf, size, size);
+  if (byte_cnt != 0)
+    fail ("pread() at end of file returned %d instead of 0", byte_cnt);
+  CHECK (pread (STDIN_FILENO, buf, size, 0) == -1, "pread() from stdin fails");
+
+  check_file_handle (handle, "test.txt", sample, size);
+}
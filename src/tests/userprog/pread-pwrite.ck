@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "test.txt"
+(pread-pwrite) open "test.txt"
+(pread-pwrite) pread() from stdin fails
+(pread-pwrite) verified contents of "test.txt"
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Writes the sample with one writev() call from three buffers
+   and reads it back with one readv() call into three buffers of
+   different sizes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  size_t size = sizeof sample - 1;
+  char a[17], b[101], c[sizeof sample];
+  char buf[sizeof sample];
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  iov[0].iov_base = (char *) sample;
+  iov[0].iov_len = 100;
+  iov[1].iov_base = (char *) sample + 100;
+  iov[1].iov_len = 1;
+  iov[2].iov_base = (char *) sample + 101;
+  iov[2].iov_len = size - 101;
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("writev() returned %d instead of %zu", byte_cnt, size);
+
+  seek (handle, 0);
+  iov[0].iov_base = a;
+  iov[0].iov_len = sizeof a;
+  iov[1].iov_base = b;
+  iov[1].iov_len = sizeof b;
+  iov[2].iov_base = c;
+  iov[2].iov_len = sizeof c;
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("readv() returned %d instead of %zu", byte_cnt, size);
+
+  memcpy (buf, a, sizeof a);
+  memcpy (buf + sizeof a, b, sizeof b);
+  memcpy (buf + sizeof a + sizeof b, c, size - sizeof a - sizeof b);
+  compare_bytes (buf, sample, size, 0, "test.txt");
+  msg ("readv() and writev() transferred %d bytes", byte_cnt);
+}
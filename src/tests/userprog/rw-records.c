@@ -0,0 +1,94 @@
+/* Reads a file of fixed-size records three ways: with a seek()
+   and a read() per record, with a pread() per record, and with
+   a single readv() into one buffer per record, checking the
+   records each time and reporting how many system calls each
+   way took.
+
+   The test runs with -scstats, so the process's system call
+   profile, printed when it exits, shows the calls and cycles of
+   each kind.  rw-records.ck checks that profile against the
+   calls counted here, so the test makes no other seek(),
+   read(), pread(), or readv() calls. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RECORD_CNT 64
+#define RECORD_SIZE 64
+
+static char records[RECORD_CNT][RECORD_SIZE];
+static char buf[RECORD_CNT][RECORD_SIZE];
+static struct iovec iov[RECORD_CNT];
+
+/* Reports reading the records HOW in CALL_CNT system calls. */
+static void
+report (const char *how, int call_cnt) 
+{
+  msg ("%s: %d records in %d system call%s",
+       how, RECORD_CNT, call_cnt, call_cnt != 1 ? "s" : "");
+}
+
+/* Checks that BUF holds the records and then clears it. */
+static void
+check_records (void) 
+{
+  compare_bytes (buf, records, sizeof records, 0, "records");
+  memset (buf, 0, sizeof buf);
+}
+
+void
+test_main (void) 
+{
+  int handle, handle2, call_cnt;
+  size_t i;
+
+  for (i = 0; i < RECORD_CNT; i++) 
+    {
+      memset (records[i], 'a' + i % 26, RECORD_SIZE);
+      iov[i].iov_base = records[i];
+      iov[i].iov_len = RECORD_SIZE;
+    }
+
+  CHECK (create ("records", sizeof records), "create \"records\"");
+  CHECK ((handle = open ("records")) > 1, "open \"records\"");
+  CHECK (writev (handle, iov, RECORD_CNT) == sizeof records,
+         "write %d records with writev", RECORD_CNT);
+
+  /* Seek and read each record. */
+  call_cnt = 0;
+  for (i = 0; i < RECORD_CNT; i++) 
+    {
+      seek (handle, i * RECORD_SIZE);
+      call_cnt++;
+      if (read (handle, buf[i], RECORD_SIZE) != RECORD_SIZE)
+        fail ("read of record %zu failed", i);
+      call_cnt++;
+    }
+  check_records ();
+  report ("seek+read", call_cnt);
+
+  /* Pread each record. */
+  call_cnt = 0;
+  for (i = 0; i < RECORD_CNT; i++) 
+    {
+      if (pread (handle, buf[i], RECORD_SIZE, i * RECORD_SIZE) != RECORD_SIZE)
+        fail ("pread of record %zu failed", i);
+      call_cnt++;
+    }
+  check_records ();
+  report ("pread", call_cnt);
+
+  /* Readv all the records through a new handle, which starts
+     at offset 0 without a seek. */
+  CHECK ((handle2 = open ("records")) > 1, "open \"records\" again");
+  for (i = 0; i < RECORD_CNT; i++)
+    iov[i].iov_base = buf[i];
+  call_cnt = 0;
+  if (readv (handle2, iov, RECORD_CNT) != sizeof records)
+    fail ("readv of records failed");
+  call_cnt++;
+  check_records ();
+  report ("readv", call_cnt);
+}
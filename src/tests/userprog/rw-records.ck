@@ -0,0 +1,40 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+# Check the lines that the test itself prints.  The cycle counts
+# in the system call profile vary from run to run.
+my (@expected) = ("(rw-records) begin",
+		  "(rw-records) create \"records\"",
+		  "(rw-records) open \"records\"",
+		  "(rw-records) write 64 records with writev",
+		  "(rw-records) seek+read: 64 records in 128 system calls",
+		  "(rw-records) pread: 64 records in 64 system calls",
+		  "(rw-records) open \"records\" again",
+		  "(rw-records) readv: 64 records in 1 system call",
+		  "(rw-records) end",
+		  "rw-records: exit(0)");
+my (@actual) = grep (/^\(rw-records\) |^rw-records: exit/, @output);
+fail "expected output:\n  " . join ("\n  ", @expected)
+  . "\nactual output:\n  " . join ("\n  ", @actual) . "\n"
+  if join ("\n", @actual) ne join ("\n", @expected);
+
+# Check the kernel's count of each kind of call, from the
+# profile printed at exit, against the calls the test made.
+my (%calls);
+for (@output) {
+    $calls{$1} = $2 if /^rw-records:   (\S+)\s+(\d+) calls\s+\d+ cycles/;
+}
+fail "no system call profile in output\n" if !%calls;
+my (%expected_calls) = (seek => 64, read => 64, pread => 64, readv => 1);
+for my $call (sort keys %expected_calls) {
+    my ($cnt) = defined $calls{$call} ? $calls{$call} : 0;
+    fail "kernel counted $cnt $call calls, expected $expected_calls{$call}\n"
+      if $cnt != $expected_calls{$call};
+}
+pass;
@@ -0,0 +1,31 @@
+/* Executes and waits for many child processes, one after
+   another, waiting for each of them twice.  The kernel must
+   free each child's exit record once the child is waited for,
+   which wait-many.ck checks in the kernel's exit statistics. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of children to run. */
+#define CHILD_CNT 32
+
+void
+test_main (void) 
+{
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      pid_t child = exec ("child-simple");
+      int status;
+
+      CHECK (child != PID_ERROR, "exec child %d", i);
+      if ((status = wait (child)) != 81)
+        fail ("wait for child %d returned %d (expected 81)", i, status);
+      if ((status = wait (child)) != -1)
+        fail ("second wait for child %d returned %d (expected -1)",
+              i, status);
+    }
+  msg ("waited for %d children", CHILD_CNT);
+}
@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+
+# 32 children plus wait-many itself, each waited for once.
+my ($child_cnt) = 32;
+my (@output) = read_text_file ("$test.output");
+my ($exec) = grep (/^Exec: /, @output);
+my ($wait) = grep (/^Wait: /, @output);
+fail "missing exec statistics\n" if !defined $exec;
+fail "missing wait statistics\n" if !defined $wait;
+my ($loaded) = $exec =~ /^Exec: (\d+) programs loaded/
+  or fail "can't parse \"$exec\"\n";
+my ($waited, $live)
+  = $wait =~ /^Wait: (\d+) children waited for, \d+ cycles per wait, (\d+) exit records live$/
+  or fail "can't parse \"$wait\"\n";
+fail "$loaded programs loaded, expected " . ($child_cnt + 1) . "\n"
+  if $loaded != $child_cnt + 1;
+fail "$waited children waited for, expected " . ($child_cnt + 1) . "\n"
+  if $waited != $child_cnt + 1;
+fail "$live exit records leaked\n" if $live != 0;
+
+my ($expected) = "(wait-many) begin\n"
+  . ("(child-simple) run\nchild-simple: exit(81)\n" x $child_cnt)
+  . "(wait-many) waited for $child_cnt children\n"
+  . "(wait-many) end\n"
+  . "wait-many: exit(0)\n";
+check_expected ([$expected]);
+pass;
@@ -25,7 +25,9 @@
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
+#include "userprog/fdtable.h"
 #include "userprog/gdt.h"
+#include "userprog/image.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #else
@@ -34,9 +36,17 @@
 #ifdef FILESYS
 #include "devices/block.h"
 #include "devices/ide.h"
+#include "devices/integrity.h"
+#include "devices/ramdisk.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/evict.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -52,6 +62,12 @@ static const char *scratch_bdev_name;
 #ifdef VM
 static const char *swap_bdev_name;
 #endif
+
+/* -ramdisk: Size of RAM disk to create, in kB. */
+static size_t ramdisk_kb;
+
+/* -integrity: Block device roles to stack integrity devices on. */
+static bool integrity_roles[BLOCK_ROLE_CNT];
 #endif /* FILESYS */
 
 /* -ul: Maximum number of pages to put into palloc's user pool. */
@@ -68,6 +84,7 @@ static void usage (void);
 #ifdef FILESYS
 static void locate_block_devices (void);
 static void locate_block_device (enum block_type, const char *name);
+static void set_integrity_role (const char *role);
 #endif
 
 int main (void) NO_RETURN;
@@ -113,6 +130,7 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  image_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -123,10 +141,18 @@ main (void)
 #ifdef FILESYS
   /* Initialize file system. */
   ide_init ();
+  ramdisk_init (ramdisk_kb * 1024 / BLOCK_SECTOR_SIZE);
   locate_block_devices ();
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init ();
+  page_init ();
+  swap_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -251,6 +277,10 @@ parse_options (char **argv)
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
 #endif
+      else if (!strcmp (name, "-ramdisk"))
+        ramdisk_kb = atoi (value);
+      else if (!strcmp (name, "-integrity"))
+        set_integrity_role (value);
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
@@ -259,6 +289,21 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-fdl"))
+        fd_limit = atoi (value);
+      else if (!strcmp (name, "-scstats"))
+        syscall_stats_enabled = true;
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-sl"))
+        stack_page_limit = atoi (value);
+      else if (!strcmp (name, "-vmstats"))
+        page_stats_enabled = true;
+      else if (!strcmp (name, "-evict")) 
+        {
+          if (!evict_set_policy (value))
+            PANIC ("unknown eviction policy `%s'", value);
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -292,6 +337,15 @@ run_task (char **argv)
   printf ("Execution of '%s' complete.\n", task);
 }
 
+#ifdef FILESYS
+/* Prints block device statistics gathered so far. */
+static void
+print_block_stats (char **argv UNUSED)
+{
+  block_print_stats ();
+}
+#endif
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -315,6 +369,7 @@ run_actions (char **argv)
       {"rm", 2, fsutil_rm},
       {"extract", 1, fsutil_extract},
       {"append", 2, fsutil_append},
+      {"blockstats", 1, print_block_stats},
 #endif
       {NULL, 0, NULL},
     };
@@ -361,6 +416,7 @@ usage (void)
           "  ls                 List files in the root directory.\n"
           "  cat FILE           Print FILE to the console.\n"
           "  rm FILE            Delete FILE.\n"
+          "  blockstats         Print block device I/O statistics.\n"
           "Use these actions indirectly via `pintos' -g and -p options:\n"
           "  extract            Untar from scratch device into file system.\n"
           "  append FILE        Append FILE to tar file on scratch device.\n"
@@ -376,11 +432,24 @@ usage (void)
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
 #endif
+          "  -ramdisk=SIZE      Create a SIZE kB RAM disk named ram0.\n"
+          "  -integrity=ROLE    Checksum every sector of the ROLE device,\n"
+          "                     e.g. filesys or swap.  The first use on\n"
+          "                     filesys must also format it with -f.\n"
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -fdl=COUNT         Limit each process to COUNT file descriptors.\n"
+          "  -scstats           Profile system calls, per process and\n"
+          "                     in total at shutdown.\n"
+#endif
+#ifdef VM
+          "  -sl=COUNT          Limit each user stack to COUNT pages.\n"
+          "  -vmstats           Print paging statistics at process exit.\n"
+          "  -evict=POLICY      Evict pages by POLICY: clock (default),\n"
+          "                     esc (enhanced second chance), wsclock.\n"
 #endif
           );
   shutdown_power_off ();
@@ -420,10 +489,40 @@ locate_block_device (enum block_type role, const char *name)
           break;
     }
 
+  if (block != NULL && integrity_roles[role])
+    {
+      /* Only a device whose contents are being discarded may
+         have an integrity header put on it: the file system
+         device when formatting it, or the swap device. */
+      struct block *parent = block;
+      bool format = role == BLOCK_SWAP
+                    || (role == BLOCK_FILESYS && format_filesys);
+      block = integrity_attach (parent, format);
+      if (block == NULL)
+        PANIC ("%s: cannot use for integrity checking", block_name (parent));
+    }
+
   if (block != NULL)
     {
       printf ("%s: using %s\n", block_type_name (role), block_name (block));
       block_set_role (role, block);
     }
 }
+
+/* Arranges for the block device that takes on the role named
+   ROLE, e.g. "filesys", to be wrapped in an integrity device
+   that verifies a checksum on every sector read. */
+static void
+set_integrity_role (const char *role)
+{
+  enum block_type type;
+
+  for (type = 0; type < BLOCK_ROLE_CNT; type++)
+    if (role != NULL && !strcmp (role, block_type_name (type)))
+      {
+        integrity_roles[type] = true;
+        return;
+      }
+  PANIC ("unknown block device role `%s' for -integrity", role);
+}
 #endif
@@ -336,3 +336,394 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RWLOCK.  Any number of threads may hold a
+   readers-writer lock for reading at once, but a thread holding
+   it for writing excludes all others.  Like locks, readers-writer
+   locks are not recursive, not even for reading: a thread that
+   already holds RWLOCK for reading and asks for it again can
+   deadlock behind a waiting writer.
+
+   Writers take precedence: once a writer is waiting, new readers
+   wait too, so that a steady stream of readers cannot starve
+   writers.  When the lock comes free, it goes to the waiting
+   writer with the highest priority, or if there is none, to all
+   of the waiting readers at once.  The lock is handed directly
+   to the threads it wakes, so a thread that arrives in the
+   meantime cannot take it from them. */
+void
+rwlock_init (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+
+  rwlock->reader_cnt = 0;
+  rwlock->writer = NULL;
+  list_init (&rwlock->read_waiters);
+  list_init (&rwlock->write_waiters);
+}
+
+/* Returns true if the priority of the thread that A_ is the
+   `elem' of is less than that of the thread that B_ is the
+   `elem' of. */
+static bool
+priority_less (const struct list_elem *a_, const struct list_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->priority < b->priority;
+}
+
+/* If any writers are waiting for RWLOCK, gives the lock to the
+   one with the highest priority, wakes it up, and returns true.
+   Otherwise, returns false.  RWLOCK must be free and interrupts
+   must be off. */
+static bool
+wake_writer (struct rwlock *rwlock) 
+{
+  struct thread *t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (rwlock->writer == NULL && rwlock->reader_cnt == 0);
+
+  if (list_empty (&rwlock->write_waiters))
+    return false;
+
+  t = list_entry (list_max (&rwlock->write_waiters, priority_less, NULL),
+                  struct thread, elem);
+  list_remove (&t->elem);
+  rwlock->writer = t;
+  thread_unblock (t);
+  return true;
+}
+
+/* Gives RWLOCK to all of the readers waiting for it and wakes
+   them up.  No writer may hold RWLOCK and interrupts must be
+   off. */
+static void
+wake_readers (struct rwlock *rwlock) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (rwlock->writer == NULL);
+
+  while (!list_empty (&rwlock->read_waiters)) 
+    {
+      struct list_elem *e = list_pop_front (&rwlock->read_waiters);
+      rwlock->reader_cnt++;
+      thread_unblock (list_entry (e, struct thread, elem));
+    }
+}
+
+/* Acquires RWLOCK for reading, sleeping until no writer holds it
+   or is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler.  This function may be called with
+   interrupts disabled, but interrupts will be turned back on if
+   we need to sleep. */
+void
+rwlock_acquire_read (struct rwlock *rwlock) 
+{
+  enum intr_level old_level;
+
+  ASSERT (rwlock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rwlock));
+
+  old_level = intr_disable ();
+  if (rwlock->writer == NULL && list_empty (&rwlock->write_waiters))
+    rwlock->reader_cnt++;
+  else 
+    {
+      list_push_back (&rwlock->read_waiters, &thread_current ()->elem);
+      thread_block ();
+    }
+  intr_set_level (old_level);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   reading. */
+void
+rwlock_release_read (struct rwlock *rwlock) 
+{
+  enum intr_level old_level;
+
+  ASSERT (rwlock != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (rwlock->reader_cnt > 0);
+  if (--rwlock->reader_cnt == 0)
+    wake_writer (rwlock);
+  intr_set_level (old_level);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no other thread
+   holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler.  This function may be called with
+   interrupts disabled, but interrupts will be turned back on if
+   we need to sleep. */
+void
+rwlock_acquire_write (struct rwlock *rwlock) 
+{
+  enum intr_level old_level;
+
+  ASSERT (rwlock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (!rwlock_held_for_write (rwlock));
+
+  old_level = intr_disable ();
+  if (rwlock->writer == NULL && rwlock->reader_cnt == 0)
+    rwlock->writer = thread_current ();
+  else 
+    {
+      list_push_back (&rwlock->write_waiters, &thread_current ()->elem);
+      thread_block ();
+    }
+  ASSERT (rwlock_held_for_write (rwlock));
+  intr_set_level (old_level);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   writing. */
+void
+rwlock_release_write (struct rwlock *rwlock) 
+{
+  enum intr_level old_level;
+
+  ASSERT (rwlock != NULL);
+  ASSERT (rwlock_held_for_write (rwlock));
+
+  old_level = intr_disable ();
+  rwlock->writer = NULL;
+  if (!wake_writer (rwlock))
+    wake_readers (rwlock);
+  intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds RWLOCK for writing,
+   false otherwise.  (There is no way to tell whether the current
+   thread holds it for reading.) */
+bool
+rwlock_held_for_write (const struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+
+  return rwlock->writer == thread_current ();
+}
+
+/* State shared by rwlock_self_test() and its helper thread. */
+struct rwlock_test 
+  {
+    struct rwlock rwlock;               /* Lock under test. */
+    struct semaphore go, done;          /* For ping-ponging. */
+    int value;                          /* Protected by RWLOCK. */
+  };
+
+static void rwlock_test_helper (void *test_);
+
+/* Self-test for readers-writer locks that checks that two
+   threads can hold one for reading at the same time, then
+   makes them take turns holding it for writing. */
+void
+rwlock_self_test (void) 
+{
+  struct rwlock_test test;
+  int i;
+
+  printf ("Testing readers-writer locks...");
+  rwlock_init (&test.rwlock);
+  sema_init (&test.go, 0);
+  sema_init (&test.done, 0);
+  test.value = 0;
+
+  rwlock_acquire_read (&test.rwlock);
+  thread_create ("rwlock-test", PRI_DEFAULT, rwlock_test_helper, &test);
+  sema_down (&test.done);
+  rwlock_release_read (&test.rwlock);
+
+  for (i = 0; i < 10; i++) 
+    {
+      rwlock_acquire_write (&test.rwlock);
+      test.value++;
+      rwlock_release_write (&test.rwlock);
+      sema_up (&test.go);
+      sema_down (&test.done);
+    }
+  ASSERT (test.value == 20);
+  printf ("done.\n");
+}
+
+/* Thread function used by rwlock_self_test(). */
+static void
+rwlock_test_helper (void *test_) 
+{
+  struct rwlock_test *test = test_;
+  int i;
+
+  /* The main thread holds the lock for reading, and so may we. */
+  rwlock_acquire_read (&test->rwlock);
+  sema_up (&test->done);
+  rwlock_release_read (&test->rwlock);
+
+  for (i = 0; i < 10; i++) 
+    {
+      sema_down (&test->go);
+      rwlock_acquire_write (&test->rwlock);
+      test->value++;
+      rwlock_release_write (&test->rwlock);
+      sema_up (&test->done);
+    }
+}
+
+/* Initializes SEQLOCK.
+
+   A sequence lock protects a small record that is read much more
+   often than it is written.  Readers take no lock at all.
+   Instead, they note the sequence number before reading, copy
+   the record, and then check whether the sequence number
+   changed, in which case a write overlapped their read and they
+   must try again:
+
+        unsigned seq;
+        do 
+          {
+            seq = seqlock_read_begin (&sl);
+            ...copy the record...
+          }
+        while (seqlock_read_retry (&sl, seq));
+
+   Writers run with interrupts disabled, so they exclude each
+   other, and a reader can only be overlapped by a write by
+   being preempted or interrupted partway through.  Thus, readers
+   may also run in interrupt handlers.  Writes must be short and
+   must not sleep. */
+void
+seqlock_init (struct seqlock *sl) 
+{
+  ASSERT (sl != NULL);
+
+  sl->seq = 0;
+}
+
+/* Starts reading the record that SL protects and returns the
+   sequence number to pass to seqlock_read_retry(). */
+unsigned
+seqlock_read_begin (const struct seqlock *sl) 
+{
+  unsigned seq;
+
+  ASSERT (sl != NULL);
+
+  seq = sl->seq;
+  barrier ();
+  return seq;
+}
+
+/* Returns true if the record that SL protects was written since
+   the call to seqlock_read_begin() that returned SEQ, meaning
+   that what was read may be inconsistent and must be read
+   again. */
+bool
+seqlock_read_retry (const struct seqlock *sl, unsigned seq) 
+{
+  ASSERT (sl != NULL);
+
+  barrier ();
+  return (seq & 1) != 0 || sl->seq != seq;
+}
+
+/* Starts writing the record that SL protects, disabling
+   interrupts until seqlock_write_end(). */
+void
+seqlock_write_begin (struct seqlock *sl) 
+{
+  enum intr_level old_level;
+
+  ASSERT (sl != NULL);
+
+  old_level = intr_disable ();
+  sl->old_level = old_level;
+  sl->seq++;
+  barrier ();
+}
+
+/* Finishes writing the record that SL protects. */
+void
+seqlock_write_end (struct seqlock *sl) 
+{
+  ASSERT (sl != NULL);
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (sl->seq & 1);
+
+  barrier ();
+  sl->seq++;
+  intr_set_level (sl->old_level);
+}
+
+/* State shared by seqlock_self_test() and its helper thread. */
+struct seqlock_test 
+  {
+    struct seqlock seqlock;             /* Sequence lock under test. */
+    struct semaphore go, done;          /* For ping-ponging. */
+    int a, b;                           /* Protected by SEQLOCK. */
+  };
+
+static void seqlock_test_helper (void *test_);
+
+/* Self-test for sequence locks that makes another thread write
+   the record in the middle of each read, and checks that the
+   read is retried and then comes out consistent. */
+void
+seqlock_self_test (void) 
+{
+  struct seqlock_test test;
+  int i;
+
+  printf ("Testing sequence locks...");
+  seqlock_init (&test.seqlock);
+  sema_init (&test.go, 0);
+  sema_init (&test.done, 0);
+  test.a = test.b = 0;
+  thread_create ("seqlock-test", PRI_DEFAULT, seqlock_test_helper, &test);
+
+  for (i = 0; i < 10; i++) 
+    {
+      unsigned seq = seqlock_read_begin (&test.seqlock);
+      int a = test.a;
+      int b;
+
+      /* Let the helper write in the middle of our read. */
+      sema_up (&test.go);
+      sema_down (&test.done);
+      b = test.b;
+      ASSERT (seqlock_read_retry (&test.seqlock, seq));
+
+      seq = seqlock_read_begin (&test.seqlock);
+      a = test.a;
+      b = test.b;
+      ASSERT (!seqlock_read_retry (&test.seqlock, seq));
+      ASSERT (a == b && a == i + 1);
+    }
+  printf ("done.\n");
+}
+
+/* Thread function used by seqlock_self_test(). */
+static void
+seqlock_test_helper (void *test_) 
+{
+  struct seqlock_test *test = test_;
+  int i;
+
+  for (i = 0; i < 10; i++) 
+    {
+      sema_down (&test->go);
+      seqlock_write_begin (&test->seqlock);
+      test->a++;
+      test->b++;
+      seqlock_write_end (&test->seqlock);
+      sema_up (&test->done);
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore 
@@ -41,6 +42,37 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock. */
+struct rwlock 
+  {
+    unsigned reader_cnt;        /* Number of readers holding the lock. */
+    struct thread *writer;      /* Writer holding the lock, or null. */
+    struct list read_waiters;   /* Threads waiting to read. */
+    struct list write_waiters;  /* Threads waiting to write. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+void rwlock_self_test (void);
+
+/* Sequence lock. */
+struct seqlock 
+  {
+    unsigned seq;               /* Odd while a write is in progress. */
+    enum intr_level old_level;  /* Interrupt level to restore after write. */
+  };
+
+void seqlock_init (struct seqlock *);
+unsigned seqlock_read_begin (const struct seqlock *);
+bool seqlock_read_retry (const struct seqlock *, unsigned seq);
+void seqlock_write_begin (struct seqlock *);
+void seqlock_write_end (struct seqlock *);
+void seqlock_self_test (void);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
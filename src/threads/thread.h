@@ -2,8 +2,16 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
 #include <stdint.h>
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#include "userprog/syscall.h"
+#endif
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -96,6 +104,28 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct file *executable;            /* Running executable, or null. */
+    int exit_code;                      /* Exit code. */
+    struct exit_record *exit_record;    /* Shared with parent, or null. */
+    struct hash *children;              /* Children's exit records. */
+
+    /* Owned by userprog/syscall.c. */
+    void *user_esp;                     /* User esp on system call entry. */
+    struct fd_table fds;                /* Open file descriptors. */
+    struct syscall_stats syscall_stats; /* System call profile. */
+#endif
+#ifdef FILESYS
+    /* Owned by filesys/journal.c. */
+    unsigned journal_depth;             /* Nesting of journal operations. */
+#endif
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash pages;                  /* Supplemental page table. */
+    struct page_stats page_stats;       /* Paging statistics. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapping;                   /* Next mapping identifier. */
 #endif
 
     /* Owned by thread.c. */
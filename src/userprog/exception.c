@@ -4,6 +4,11 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "devices/timer.h"
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -148,9 +153,44 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* Bring in the page that FAULT_ADDR refers to, if it is part
+     of the process's address space but not yet in memory, or
+     grow the stack to cover it.  A fault taken inside a system
+     call finds the user's stack pointer where the system call
+     handler saved it.  A write to a present page may be the
+     first write to a page mapped to the shared zero page. */
+  {
+    struct thread *t = thread_current ();
+    uint64_t start = timer_cycles ();
+    bool handled = false;
+
+    if (not_present) 
+      {
+        void *esp = user ? f->esp : t->user_esp;
+        handled = (page_in (fault_addr, write)
+                   || page_grow_stack (fault_addr, esp));
+      }
+    else if (write)
+      handled = page_in (fault_addr, true);
+
+    t->page_stats.fault_cycles += timer_cycles () - start;
+    if (handled)
+      return;
+  }
+#endif
+
+  /* In the kernel, only get_user() and put_user() in the system
+     call layer access user addresses that may be invalid.  They
+     expect a fault to resume at the address they put in EAX,
+     with EAX set to 0 to report failure. */
+  if (!user && is_user_vaddr (fault_addr)) 
+    {
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0;
+      return;
+    }
+
   printf ("Page fault at %p: %s error %s page in %s context.\n",
           fault_addr,
           not_present ? "not present" : "rights violation",
@@ -0,0 +1,121 @@
+#include "userprog/fdtable.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+
+/* Maximum number of descriptors per process, counting the
+   console descriptors 0 and 1. */
+size_t fd_limit = 1024;
+
+/* Number of slots in a table when it is first used. */
+#define FD_INITIAL_SIZE 16
+
+static bool grow (struct fd_table *);
+
+/* Associates FILE with the lowest free descriptor in TABLE and
+   returns it.  Returns -1 if TABLE already holds fd_limit
+   descriptors or if memory is exhausted. */
+int
+fd_alloc (struct fd_table *table, struct file *file)
+{
+  size_t fd;
+
+  ASSERT (file != NULL);
+
+  fd = table->used != NULL
+        ? bitmap_scan (table->used, table->first_free, 1, false)
+        : BITMAP_ERROR;
+  if (fd == BITMAP_ERROR)
+    {
+      if (!grow (table))
+        return -1;
+      fd = table->first_free;
+    }
+
+  bitmap_mark (table->used, fd);
+  table->files[fd] = file;
+  table->first_free = fd + 1;
+  return fd;
+}
+
+/* Returns the file associated with descriptor FD in TABLE, or a
+   null pointer if FD is not open. */
+struct file *
+fd_lookup (const struct fd_table *table, int fd)
+{
+  if (fd < 0 || (size_t) fd >= table->size)
+    return NULL;
+  return table->files[fd];
+}
+
+/* Frees descriptor FD in TABLE and returns the file that was
+   associated with it, or a null pointer if FD was not open.  The
+   caller is responsible for closing the file. */
+struct file *
+fd_free (struct fd_table *table, int fd)
+{
+  struct file *file = fd_lookup (table, fd);
+
+  if (file != NULL)
+    {
+      table->files[fd] = NULL;
+      bitmap_reset (table->used, fd);
+      if ((size_t) fd < table->first_free)
+        table->first_free = fd;
+    }
+  return file;
+}
+
+/* Frees the memory used by TABLE, which must not have any open
+   descriptors left, and reinitializes it as empty. */
+void
+fd_table_destroy (struct fd_table *table)
+{
+  if (table->used != NULL)
+    {
+      ASSERT (bitmap_count (table->used, 0, table->size, true) == 2);
+      bitmap_destroy (table->used);
+    }
+  free (table->files);
+  memset (table, 0, sizeof *table);
+}
+
+/* Doubles the number of slots in TABLE, up to fd_limit, creating
+   it with the console descriptors marked in use if it is empty.
+   Returns true if successful, false on failure. */
+static bool
+grow (struct fd_table *table)
+{
+  size_t new_size = table->size == 0 ? FD_INITIAL_SIZE : table->size * 2;
+  struct file **files;
+  struct bitmap *used;
+
+  if (new_size > fd_limit)
+    new_size = fd_limit;
+  if (new_size <= table->size || new_size <= 2)
+    return false;
+
+  files = realloc (table->files, new_size * sizeof *files);
+  if (files == NULL)
+    return false;
+  memset (files + table->size, 0,
+          (new_size - table->size) * sizeof *files);
+  table->files = files;
+
+  used = bitmap_create (new_size);
+  if (used == NULL)
+    return false;
+  if (table->used != NULL)
+    {
+      bitmap_set_multiple (used, 0, table->size, true);
+      bitmap_destroy (table->used);
+    }
+  else
+    bitmap_set_multiple (used, 0, 2, true);
+  table->used = used;
+
+  table->first_free = table->size == 0 ? 2 : table->size;
+  table->size = new_size;
+  return true;
+}
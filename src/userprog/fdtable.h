@@ -0,0 +1,27 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stddef.h>
+
+struct bitmap;
+struct file;
+
+/* A process's file descriptor table.
+   Descriptors 0 and 1 are the console and are never allocated. */
+struct fd_table
+  {
+    struct file **files;        /* Open files, indexed by descriptor. */
+    struct bitmap *used;        /* Descriptors in use. */
+    size_t size;                /* Number of slots in FILES and USED. */
+    size_t first_free;          /* No free descriptor is below this. */
+  };
+
+/* -fdl: Maximum number of descriptors per process. */
+extern size_t fd_limit;
+
+int fd_alloc (struct fd_table *, struct file *);
+struct file *fd_lookup (const struct fd_table *, int fd);
+struct file *fd_free (struct fd_table *, int fd);
+void fd_table_destroy (struct fd_table *);
+
+#endif /* userprog/fdtable.h */
@@ -0,0 +1,163 @@
+#include "userprog/image.h"
+#include <debug.h>
+#include <list.h>
+#include "filesys/inode.h"
+#include "threads/synch.h"
+
+/* Cache of parsed executable images, so that running the same
+   program again skips reading and validating its ELF headers.
+
+   Each entry holds its inode open, so that the inode's version
+   number stays meaningful, and is stale once the inode's version
+   no longer matches.  Removing an executable drops its entry, so
+   that the entry does not keep the removed inode's sectors
+   allocated, and image_done() drops the rest before the file
+   system shuts down. */
+
+/* Number of images cached. */
+#define IMAGE_CACHE_CNT 8
+
+/* A cache entry. */
+struct image_entry
+  {
+    struct list_elem elem;      /* Element in `lru'. */
+    struct inode *inode;        /* Executable's inode, or null. */
+    unsigned version;           /* Inode version when parsed. */
+    struct image image;         /* Parsed image. */
+  };
+
+static struct image_entry entries[IMAGE_CACHE_CNT];
+
+/* All entries, most recently used first. */
+static struct list lru;
+
+/* Protects the cache. */
+static struct lock image_lock;
+
+/* Initializes the image cache. */
+void
+image_init (void) 
+{
+  size_t i;
+
+  list_init (&lru);
+  lock_init (&image_lock);
+  for (i = 0; i < IMAGE_CACHE_CNT; i++)
+    list_push_back (&lru, &entries[i].elem);
+}
+
+/* Returns the entry for INODE, or a null pointer if there is
+   none.  The caller must hold image_lock. */
+static struct image_entry *
+find_entry (struct inode *inode) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&lru); e != list_end (&lru); e = list_next (e))
+    {
+      struct image_entry *ie = list_entry (e, struct image_entry, elem);
+      if (ie->inode == inode)
+        return ie;
+    }
+  return NULL;
+}
+
+/* Looks for a current image of INODE in the cache.  If there is
+   one, copies it into *IMAGE and returns true.  Otherwise,
+   returns false. */
+bool
+image_lookup (struct inode *inode, struct image *image) 
+{
+  struct image_entry *ie;
+  bool found = false;
+
+  ASSERT (inode != NULL);
+
+  lock_acquire (&image_lock);
+  ie = find_entry (inode);
+  if (ie != NULL && ie->version == inode_version (inode)) 
+    {
+      *image = ie->image;
+      list_remove (&ie->elem);
+      list_push_front (&lru, &ie->elem);
+      found = true;
+    }
+  lock_release (&image_lock);
+
+  return found;
+}
+
+/* Caches IMAGE as the image of INODE, which was parsed from
+   INODE's contents as of VERSION, replacing any older image of
+   INODE or else the least recently used entry.  Does nothing if
+   INODE has been removed, because nothing can run it again. */
+void
+image_insert (struct inode *inode, unsigned version,
+              const struct image *image) 
+{
+  struct image_entry *ie;
+  struct inode *evicted = NULL;
+
+  ASSERT (inode != NULL);
+
+  lock_acquire (&image_lock);
+  if (inode_is_removed (inode)) 
+    {
+      lock_release (&image_lock);
+      return;
+    }
+  ie = find_entry (inode);
+  if (ie == NULL) 
+    {
+      ie = list_entry (list_back (&lru), struct image_entry, elem);
+      evicted = ie->inode;
+      ie->inode = inode_reopen (inode);
+    }
+  ie->version = version;
+  ie->image = *image;
+  list_remove (&ie->elem);
+  list_push_front (&lru, &ie->elem);
+  lock_release (&image_lock);
+
+  inode_close (evicted);
+}
+
+/* Drops INODE's entry from the cache, if it has one.  Called
+   when INODE is removed, so the caller must have it open. */
+void
+image_invalidate (struct inode *inode) 
+{
+  struct image_entry *ie;
+  struct inode *dropped = NULL;
+
+  ASSERT (inode != NULL);
+
+  lock_acquire (&image_lock);
+  ie = find_entry (inode);
+  if (ie != NULL) 
+    {
+      dropped = ie->inode;
+      ie->inode = NULL;
+      list_remove (&ie->elem);
+      list_push_back (&lru, &ie->elem);
+    }
+  lock_release (&image_lock);
+
+  inode_close (dropped);
+}
+
+/* Empties the cache, closing the inodes that it holds open.
+   Must be called before the free map is closed. */
+void
+image_done (void) 
+{
+  size_t i;
+
+  lock_acquire (&image_lock);
+  for (i = 0; i < IMAGE_CACHE_CNT; i++) 
+    {
+      inode_close (entries[i].inode);
+      entries[i].inode = NULL;
+    }
+  lock_release (&image_lock);
+}
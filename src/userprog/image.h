@@ -0,0 +1,38 @@
+#ifndef USERPROG_IMAGE_H
+#define USERPROG_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/* Maximum number of loadable segments in an executable. */
+#define IMAGE_SEGMENT_CNT 16
+
+/* A loadable segment, in the form that load_segment() takes. */
+struct image_segment
+  {
+    off_t file_page;            /* Page-aligned offset in file. */
+    uint8_t *upage;             /* Page-aligned user address. */
+    uint32_t read_bytes;        /* Bytes to read from file. */
+    uint32_t zero_bytes;        /* Bytes to zero after those. */
+    bool writable;              /* Writable by user process? */
+  };
+
+/* A parsed and validated executable image. */
+struct image
+  {
+    void (*entry) (void);       /* Entry point. */
+    size_t segment_cnt;         /* Number of segments. */
+    struct image_segment segments[IMAGE_SEGMENT_CNT];
+  };
+
+void image_init (void);
+void image_done (void);
+bool image_lookup (struct inode *, struct image *);
+void image_insert (struct inode *, unsigned version, const struct image *);
+void image_invalidate (struct inode *);
+
+#endif /* userprog/image.h */
@@ -6,51 +6,144 @@
 #include <stdlib.h>
 #include <string.h>
 #include "userprog/gdt.h"
+#include "userprog/image.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
-static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static bool load (const char *cmd_line, void (**eip) (void), void **esp);
+
+/* Exec statistics. */
+static unsigned exec_cnt;       /* Programs successfully loaded. */
+static uint64_t exec_cycles;    /* Cycles spent loading them. */
+
+/* Wait statistics. */
+static unsigned wait_cnt;       /* Children successfully waited for. */
+static uint64_t wait_cycles;    /* Cycles spent waiting for them. */
+static unsigned live_cnt;       /* Exit records allocated, not freed. */
+
+/* Tracks the completion of a child process.  Shared between
+   the child, which reports its exit code, and its parent, which
+   finds the record by tid in its `children' table.  Freed when
+   both of them have let go of it. */
+struct exit_record 
+  {
+    struct hash_elem elem;              /* Element in parent's `children'. */
+    struct lock lock;                   /* Protects ref_cnt. */
+    int ref_cnt;                        /* 2=child and parent both alive,
+                                           1=either child or parent alive,
+                                           0=child and parent both dead. */
+    tid_t tid;                          /* Child thread id. */
+    int exit_code;                      /* Child exit code, if dead. */
+    struct semaphore dead;              /* 1=child alive, 0=child dead. */
+  };
+
+static hash_hash_func exit_record_hash;
+static hash_less_func exit_record_less;
+static hash_action_func destroy_exit_record;
+static void release_exit_record (struct exit_record *);
+static void free_exit_record (struct exit_record *);
 
-/* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+/* Data structure shared between process_execute() in the
+   invoking thread and start_process() in the newly invoked
+   thread. */
+struct exec_info 
+  {
+    const char *cmd_line;               /* Program and arguments. */
+    struct semaphore load_done;         /* "Up"ed when loading complete. */
+    struct exit_record *exit_record;    /* Child process. */
+    bool success;                       /* Program successfully loaded? */
+  };
+
+/* Starts a new thread running a user program loaded from the
+   first word of CMD_LINE, passing it the words of CMD_LINE as
+   arguments, and waits for it to finish loading.  The new
+   thread may exit before process_execute() returns.  Returns
+   the new process's thread id, or TID_ERROR if the thread cannot
+   be created or the program cannot be loaded. */
 tid_t
-process_execute (const char *file_name) 
+process_execute (const char *cmd_line) 
 {
-  char *fn_copy;
+  struct thread *cur = thread_current ();
+  struct exec_info exec;
+  char thread_name[16];
+  size_t name_len;
+  uint64_t start;
+  enum intr_level old_level;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
-    return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
-
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
-  if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+  /* Name the thread after the program. */
+  cmd_line += strspn (cmd_line, " ");
+  name_len = strcspn (cmd_line, " ");
+  strlcpy (thread_name, cmd_line,
+           name_len < sizeof thread_name ? name_len + 1 : sizeof thread_name);
+
+  /* Create our table of children on first use. */
+  if (cur->children == NULL) 
+    {
+      cur->children = malloc (sizeof *cur->children);
+      if (cur->children == NULL)
+        return TID_ERROR;
+      if (!hash_init (cur->children, exit_record_hash, exit_record_less,
+                      NULL)) 
+        {
+          free (cur->children);
+          cur->children = NULL;
+          return TID_ERROR;
+        }
+    }
+
+  /* The new thread copies CMD_LINE onto its stack before it ups
+     load_done, and we don't return until then, so it can use
+     our copy directly. */
+  exec.cmd_line = cmd_line;
+  sema_init (&exec.load_done, 0);
+
+  /* Create a new thread to execute CMD_LINE. */
+  start = timer_cycles ();
+  tid = thread_create (thread_name, PRI_DEFAULT, start_process, &exec);
+  if (tid != TID_ERROR) 
+    {
+      sema_down (&exec.load_done);
+      if (exec.success)
+        {
+          uint64_t cycles = timer_cycles () - start;
+          hash_insert (cur->children, &exec.exit_record->elem);
+          old_level = intr_disable ();
+          exec_cnt++;
+          exec_cycles += cycles;
+          intr_set_level (old_level);
+        }
+      else
+        tid = TID_ERROR;
+    }
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *exec_)
 {
-  char *file_name = file_name_;
+  struct exec_info *exec = exec_;
   struct intr_frame if_;
   bool success;
 
@@ -59,10 +152,37 @@ start_process (void *file_name_)
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  success = load (exec->cmd_line, &if_.eip, &if_.esp);
+
+  /* Allocate exit record. */
+  if (success)
+    {
+      struct exit_record *er = malloc (sizeof *er);
+      exec->exit_record = thread_current ()->exit_record = er;
+      success = er != NULL;
+      if (success) 
+        {
+          enum intr_level old_level = intr_disable ();
+          live_cnt++;
+          intr_set_level (old_level);
+        }
+    }
+
+  /* Initialize exit record. */
+  if (success) 
+    {
+      lock_init (&exec->exit_record->lock);
+      exec->exit_record->ref_cnt = 2;
+      exec->exit_record->tid = thread_current ()->tid;
+      sema_init (&exec->exit_record->dead, 0);
+    }
+
+  /* Notify parent thread and clean up.  EXEC is on the parent's
+     stack, so it must not be used after this. */
+  exec->success = success;
+  sema_up (&exec->load_done);
 
   /* If load failed, quit. */
-  palloc_free_page (file_name);
   if (!success) 
     thread_exit ();
 
@@ -76,19 +196,68 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+/* Releases one reference to ER and, if it is now unreferenced,
+   frees it. */
+static void
+release_exit_record (struct exit_record *er) 
+{
+  int new_ref_cnt;
+
+  lock_acquire (&er->lock);
+  new_ref_cnt = --er->ref_cnt;
+  lock_release (&er->lock);
+  if (new_ref_cnt == 0)
+    free_exit_record (er);
+}
+
+/* Frees ER, which must be unreferenced. */
+static void
+free_exit_record (struct exit_record *er) 
+{
+  enum intr_level old_level;
+
+  free (er);
+  old_level = intr_disable ();
+  live_cnt--;
+  intr_set_level (old_level);
+}
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting.  The child is found by hashing
+   its tid, so the cost does not depend on how many children the
+   process has. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
-  return -1;
+  struct thread *cur = thread_current ();
+  struct exit_record key, *er;
+  struct hash_elem *e;
+  uint64_t start;
+  enum intr_level old_level;
+  int exit_code;
+
+  if (cur->children == NULL)
+    return -1;
+  key.tid = child_tid;
+  e = hash_delete (cur->children, &key.elem);
+  if (e == NULL)
+    return -1;
+
+  er = hash_entry (e, struct exit_record, elem);
+  start = timer_cycles ();
+  sema_down (&er->dead);
+  exit_code = er->exit_code;
+  release_exit_record (er);
+
+  old_level = intr_disable ();
+  wait_cnt++;
+  wait_cycles += timer_cycles () - start;
+  intr_set_level (old_level);
+  return exit_code;
 }
 
 /* Free the current process's resources. */
@@ -103,6 +272,10 @@ process_exit (void)
   pd = cur->pagedir;
   if (pd != NULL) 
     {
+      printf ("%s: exit(%d)\n", cur->name, cur->exit_code);
+      if (syscall_stats_enabled)
+        syscall_print_process_stats ();
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -110,10 +283,85 @@ process_exit (void)
          directory before destroying the process's page
          directory, or our active page directory will be one
          that's been freed (and cleared). */
+#ifdef VM
+      if (page_stats_enabled)
+        page_print_stats ();
+      mmap_unmap_all ();
+      page_table_destroy ();
+#endif
       cur->pagedir = NULL;
       pagedir_activate (NULL);
       pagedir_destroy (pd);
     }
+
+  /* Close our files and allow writes to our executable again. */
+  syscall_exit ();
+  file_close (cur->executable);
+  cur->executable = NULL;
+
+  /* Let go of our children's exit records. */
+  if (cur->children != NULL) 
+    {
+      hash_destroy (cur->children, destroy_exit_record);
+      free (cur->children);
+      cur->children = NULL;
+    }
+
+  /* Notify parent that we're dead.  We drop our reference before
+     waking the parent, while still holding the record's lock, so
+     that a waiting parent is always the one to free the record
+     and nothing we own outlives its process_wait(). */
+  if (cur->exit_record != NULL) 
+    {
+      struct exit_record *er = cur->exit_record;
+      int new_ref_cnt;
+
+      lock_acquire (&er->lock);
+      er->exit_code = cur->exit_code;
+      new_ref_cnt = --er->ref_cnt;
+      sema_up (&er->dead);
+      lock_release (&er->lock);
+      if (new_ref_cnt == 0)
+        free_exit_record (er);
+      cur->exit_record = NULL;
+    }
+}
+
+/* Returns a hash value for the exit record that E is in. */
+static unsigned
+exit_record_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  const struct exit_record *er = hash_entry (e, struct exit_record, elem);
+  return hash_int (er->tid);
+}
+
+/* Returns true if exit record A precedes exit record B. */
+static bool
+exit_record_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                  void *aux UNUSED) 
+{
+  const struct exit_record *a = hash_entry (a_, struct exit_record, elem);
+  const struct exit_record *b = hash_entry (b_, struct exit_record, elem);
+  return a->tid < b->tid;
+}
+
+/* Releases the parent's reference to the exit record that E is
+   in, for use when the parent exits. */
+static void
+destroy_exit_record (struct hash_elem *e, void *aux UNUSED) 
+{
+  release_exit_record (hash_entry (e, struct exit_record, elem));
+}
+
+/* Prints exec and wait statistics. */
+void
+process_print_stats (void) 
+{
+  printf ("Exec: %u programs loaded, %"PRIu64" cycles per load\n",
+          exec_cnt, exec_cnt > 0 ? exec_cycles / exec_cnt : 0);
+  printf ("Wait: %u children waited for, %"PRIu64" cycles per wait, "
+          "%u exit records live\n",
+          wait_cnt, wait_cnt > 0 ? wait_cycles / wait_cnt : 0, live_cnt);
 }
 
 /* Sets up the CPU for running user code in the current
@@ -196,31 +444,55 @@ struct Elf32_Phdr
 #define PF_R 4          /* Readable. */
 
 static bool setup_stack (void **esp);
+static char *push_args (const char *cmd_line, void **esp);
+static bool parse_image (struct file *, struct image *);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
+/* Loads an ELF executable named by the first word of CMD_LINE
+   into the current thread, passing it the words of CMD_LINE as
+   arguments.  Stores the executable's entry point into *EIP
    and its initial stack pointer into *ESP.
    Returns true if successful, false otherwise. */
 bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+load (const char *cmd_line, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  struct image image;
   struct file *file = NULL;
-  off_t file_ofs;
+  struct inode *inode;
+  char *file_name;
+  bool stack_ok = false;
   bool success = false;
-  int i;
+  size_t i;
 
   /* Allocate and activate page directory. */
+#ifdef VM
+  if (!page_table_create ())
+    goto done;
+#endif
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL) 
-    goto done;
+    {
+#ifdef VM
+      page_table_destroy ();
+#endif
+      goto done;
+    }
   process_activate ();
 
+  /* Set up stack and lay out the arguments on it.  The program
+     name is read from the stack copy of CMD_LINE, so the stack
+     page stays in memory until loading is complete. */
+  stack_ok = setup_stack (esp);
+  if (!stack_ok)
+    goto done;
+  file_name = push_args (cmd_line, esp);
+  if (file_name == NULL)
+    goto done;
+
   /* Open executable file. */
   file = filesys_open (file_name);
   if (file == NULL) 
@@ -229,31 +501,88 @@ load (const char *file_name, void (**eip) (void), void **esp)
       goto done; 
     }
 
+  /* Keep the executable open, and unmodifiable, for as long as
+     the process runs: its pages may be read in on demand. */
+  t->executable = file;
+  file_deny_write (file);
+
+  /* Parse the executable, unless its parsed image is cached. */
+  inode = file_get_inode (file);
+  if (!image_lookup (inode, &image)) 
+    {
+      unsigned version = inode_version (inode);
+      if (!parse_image (file, &image))
+        {
+          printf ("load: %s: error loading executable\n", file_name);
+          goto done; 
+        }
+      image_insert (inode, version, &image);
+    }
+
+  /* Load segments. */
+  for (i = 0; i < image.segment_cnt; i++) 
+    {
+      const struct image_segment *seg = &image.segments[i];
+      if (!load_segment (file, seg->file_page, seg->upage,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        goto done;
+    }
+
+  /* Start address. */
+  *eip = image.entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not.
+     The executable is closed in process_exit(). */
+#ifdef VM
+  if (stack_ok)
+    page_unpin (((uint8_t *) PHYS_BASE) - PGSIZE);
+#endif
+  return success;
+}
+
+/* load() helpers. */
+
+#ifndef VM
+static bool install_page (void *upage, void *kpage, bool writable);
+#endif
+
+/* Reads and validates the ELF headers of FILE and records its
+   entry point and loadable segments in *IMAGE.  Returns true if
+   successful, false if FILE is not a valid executable or has
+   more than IMAGE_SEGMENT_CNT loadable segments. */
+static bool
+parse_image (struct file *file, struct image *image) 
+{
+  struct Elf32_Ehdr ehdr;
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
       || ehdr.e_version != 1
       || ehdr.e_phentsize != sizeof (struct Elf32_Phdr)
       || ehdr.e_phnum > 1024) 
-    {
-      printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
-    }
+    return false;
 
   /* Read program headers. */
+  image->segment_cnt = 0;
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
       struct Elf32_Phdr phdr;
+      struct image_segment *seg;
+      uint32_t page_offset;
 
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
-
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        return false;
+      if (file_read_at (file, &phdr, sizeof phdr, file_ofs) != sizeof phdr)
+        return false;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -267,58 +596,39 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          return false;
         case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
+          if (!validate_segment (&phdr, file)
+              || image->segment_cnt >= IMAGE_SEGMENT_CNT) 
+            return false;
+          seg = &image->segments[image->segment_cnt++];
+          seg->writable = (phdr.p_flags & PF_W) != 0;
+          seg->file_page = phdr.p_offset & ~PGMASK;
+          seg->upage = (uint8_t *) (phdr.p_vaddr & ~PGMASK);
+          page_offset = phdr.p_vaddr & PGMASK;
+          if (phdr.p_filesz > 0)
+            {
+              /* Normal segment.
+                 Read initial part from disk and zero the rest. */
+              seg->read_bytes = page_offset + phdr.p_filesz;
+              seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
+                                 - seg->read_bytes);
+            }
+          else 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
-              uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
-              if (phdr.p_filesz > 0)
-                {
-                  /* Normal segment.
-                     Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
-                }
-              else 
-                {
-                  /* Entirely zero.
-                     Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
-                }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
+              /* Entirely zero.
+                 Don't read anything from disk. */
+              seg->read_bytes = 0;
+              seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
             }
-          else
-            goto done;
           break;
         }
     }
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
-
   /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
-
-  success = true;
-
- done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
-  return success;
+  image->entry = (void (*) (void)) ehdr.e_entry;
+  return true;
 }
-
-/* load() helpers. */
-
-static bool install_page (void *upage, void *kpage, bool writable);
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -387,7 +697,9 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifndef VM
   file_seek (file, ofs);
+#endif
   while (read_bytes > 0 || zero_bytes > 0) 
     {
       /* Calculate how to fill this page.
@@ -396,6 +708,20 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+#ifdef VM
+      /* Record where to find this page.  It is read in on the
+         first access to it, by page_in(). */
+      struct page *p = page_allocate (upage, writable);
+      if (p == NULL)
+        return false;
+      if (page_read_bytes > 0) 
+        {
+          p->file = file;
+          p->file_offset = ofs;
+          p->read_bytes = page_read_bytes;
+        }
+      ofs += page_read_bytes;
+#else
       /* Get a page of memory. */
       uint8_t *kpage = palloc_get_page (PAL_USER);
       if (kpage == NULL)
@@ -415,6 +741,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
           palloc_free_page (kpage);
           return false; 
         }
+#endif
 
       /* Advance. */
       read_bytes -= page_read_bytes;
@@ -425,10 +752,19 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+   user virtual memory.  With VM, the page is pinned, and the
+   caller must unpin it. */
 static bool
 setup_stack (void **esp) 
 {
+#ifdef VM
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+
+  if (page_allocate (upage, true) == NULL || !page_pin (upage, true))
+    return false;
+  *esp = PHYS_BASE;
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -442,8 +778,64 @@ setup_stack (void **esp)
         palloc_free_page (kpage);
     }
   return success;
+#endif
+}
+
+/* Lays out the arguments to main() at *ESP, which must be the
+   top of the freshly mapped stack page in the active page
+   directory, and updates *ESP to point to the return address.
+   The words of CMD_LINE become argv[0], argv[1], and so on.
+   CMD_LINE is copied to the top of the stack once and split
+   into words there, so that the argv strings need no further
+   copying.  Returns argv[0] if successful, or a null pointer if
+   CMD_LINE has no words or does not fit in the page. */
+static char *
+push_args (const char *cmd_line, void **esp) 
+{
+  uint8_t *bottom = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  size_t len = strlen (cmd_line) + 1;
+  char *cmd_copy, *token, *save_ptr;
+  char **argv;
+  int argc, i;
+
+  /* Copy CMD_LINE and leave room below it for a null argv[]
+     terminator plus argv, argc, and the return address. */
+  if (len > PGSIZE - 5 * sizeof (void *))
+    return NULL;
+  cmd_copy = (char *) PHYS_BASE - len;
+  strlcpy (cmd_copy, cmd_line, len);
+  argv = (char **) ROUND_DOWN ((uintptr_t) cmd_copy, sizeof (char *));
+  *--argv = NULL;
+
+  /* Push a pointer to each word as we find it.  This builds
+     argv[] in reverse order, so reverse it afterward. */
+  argc = 0;
+  for (token = strtok_r (cmd_copy, " ", &save_ptr); token != NULL;
+       token = strtok_r (NULL, " ", &save_ptr)) 
+    {
+      if ((uint8_t *) argv < bottom + 4 * sizeof (void *))
+        return NULL;
+      *--argv = token;
+      argc++;
+    }
+  if (argc == 0)
+    return NULL;
+  for (i = 0; i < argc / 2; i++) 
+    {
+      char *tmp = argv[i];
+      argv[i] = argv[argc - 1 - i];
+      argv[argc - 1 - i] = tmp;
+    }
+
+  /* Push argv, argc, and a null return address. */
+  *esp = argv;
+  *(char ***) (*esp -= sizeof argv) = argv;
+  *(int *) (*esp -= sizeof argc) = argc;
+  *(void **) (*esp -= sizeof (void *)) = NULL;
+  return argv[0];
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +855,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif
@@ -3,9 +3,10 @@
 
 #include "threads/thread.h"
 
-tid_t process_execute (const char *file_name);
+tid_t process_execute (const char *cmd_line);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+void process_print_stats (void);
 
 #endif /* userprog/process.h */
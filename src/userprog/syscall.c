@@ -1,20 +1,700 @@
 #include "userprog/syscall.h"
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include <uio.h>
+#include "userprog/fdtable.h"
+#include "userprog/process.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "devices/timer.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
+
+/* -scstats: Print system call profiles? */
+bool syscall_stats_enabled;
+
+/* System call profile for all processes. */
+static struct syscall_stats syscall_stats;
+
+/* A system call handler.  Every handler is called with four
+   arguments, of which it uses as many as it declares. */
+typedef int syscall_function (int, int, int, int);
+
+/* A system call. */
+struct syscall
+  {
+    const char *name;           /* Name, for reports. */
+    size_t arg_cnt;             /* Number of arguments. */
+    syscall_function *func;     /* Implementation. */
+  };
+
+static int sys_halt (void);
+static int sys_exit (int status);
+static int sys_exec (const char *ufile);
+static int sys_wait (tid_t);
+static int sys_create (const char *ufile, unsigned initial_size);
+static int sys_remove (const char *ufile);
+static int sys_open (const char *ufile);
+static int sys_filesize (int handle);
+static int sys_read (int handle, void *udst, unsigned size);
+static int sys_write (int handle, const void *usrc, unsigned size);
+static int sys_seek (int handle, unsigned position);
+static int sys_tell (int handle);
+static int sys_close (int handle);
+static int sys_pread (int handle, void *udst, unsigned size, unsigned ofs);
+static int sys_pwrite (int handle, const void *usrc, unsigned size,
+                       unsigned ofs);
+static int sys_readv (int handle, const struct iovec *uiov, int iov_cnt);
+static int sys_writev (int handle, const struct iovec *uiov, int iov_cnt);
+#ifdef VM
+static int sys_mmap (int handle, void *addr);
+static int sys_munmap (int mapping);
+#endif
+
+/* Initializer for a system call that takes ARG_CNT arguments
+   and is implemented by FUNC, whose name must begin with "sys_".
+   The cast through void (*) (void) is GCC's sanctioned way to
+   convert between function types. */
+#define SYSCALL(ARG_CNT, FUNC) \
+        {#FUNC + 4, ARG_CNT, \
+         (syscall_function *) (void (*) (void)) (FUNC)}
+
+/* Table of system calls, indexed by system call number.  Calls
+   with a null `func' are not implemented. */
+static const struct syscall syscall_table[SYSCALL_CNT] =
+  {
+    [SYS_HALT] = SYSCALL (0, sys_halt),
+    [SYS_EXIT] = SYSCALL (1, sys_exit),
+    [SYS_EXEC] = SYSCALL (1, sys_exec),
+    [SYS_WAIT] = SYSCALL (1, sys_wait),
+    [SYS_CREATE] = SYSCALL (2, sys_create),
+    [SYS_REMOVE] = SYSCALL (1, sys_remove),
+    [SYS_OPEN] = SYSCALL (1, sys_open),
+    [SYS_FILESIZE] = SYSCALL (1, sys_filesize),
+    [SYS_READ] = SYSCALL (3, sys_read),
+    [SYS_WRITE] = SYSCALL (3, sys_write),
+    [SYS_SEEK] = SYSCALL (2, sys_seek),
+    [SYS_TELL] = SYSCALL (1, sys_tell),
+    [SYS_CLOSE] = SYSCALL (1, sys_close),
+#ifdef VM
+    [SYS_MMAP] = SYSCALL (2, sys_mmap),
+    [SYS_MUNMAP] = SYSCALL (1, sys_munmap),
+#endif
+    [SYS_PREAD] = SYSCALL (4, sys_pread),
+    [SYS_PWRITE] = SYSCALL (4, sys_pwrite),
+    [SYS_READV] = SYSCALL (3, sys_readv),
+    [SYS_WRITEV] = SYSCALL (3, sys_writev),
+  };
 
 static void syscall_handler (struct intr_frame *);
+static void copy_in (void *, const void *, size_t);
 
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
+/* System call handler. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+syscall_handler (struct intr_frame *f)
 {
-  printf ("system call!\n");
+  struct thread *t = thread_current ();
+  const struct syscall *sc;
+  unsigned call_nr;
+  int args[4];
+  uint64_t start, cycles;
+  enum intr_level old_level;
+
+  /* Save the user stack pointer, for page faults taken while
+     accessing user memory. */
+  t->user_esp = f->esp;
+
+  /* Get the system call. */
+  copy_in (&call_nr, f->esp, sizeof call_nr);
+  if (call_nr >= sizeof syscall_table / sizeof *syscall_table
+      || syscall_table[call_nr].func == NULL)
+    thread_exit ();
+  sc = syscall_table + call_nr;
+
+  /* Get the system call arguments. */
+  ASSERT (sc->arg_cnt <= sizeof args / sizeof *args);
+  memset (args, 0, sizeof args);
+  copy_in (args, (uint32_t *) f->esp + 1, sizeof *args * sc->arg_cnt);
+
+  /* Count the call up front, because exit and halt never
+     return. */
+  t->syscall_stats.calls[call_nr]++;
+  old_level = intr_disable ();
+  syscall_stats.calls[call_nr]++;
+  intr_set_level (old_level);
+
+  /* Execute the system call,
+     and set the return value. */
+  start = timer_cycles ();
+  f->eax = sc->func (args[0], args[1], args[2], args[3]);
+  cycles = timer_cycles () - start;
+
+  t->syscall_stats.cycles[call_nr] += cycles;
+  old_level = intr_disable ();
+  syscall_stats.cycles[call_nr] += cycles;
+  intr_set_level (old_level);
+}
+
+/* Copies a byte from user address USRC to kernel address DST.
+   USRC must be below PHYS_BASE.
+   Returns true if successful, false if a segfault occurred.
+   A fault in the load is recovered by page_fault(), which sets
+   EAX to 0 and resumes at the address that EAX held: label 1. */
+static inline bool
+get_user (uint8_t *dst, const uint8_t *usrc)
+{
+  int eax;
+  asm ("movl $1f, %%eax; movb %2, %%al; movb %%al, %0; 1:"
+       : "=m" (*dst), "=&a" (eax) : "m" (*usrc));
+  return eax != 0;
+}
+
+/* Writes BYTE to user address UDST.
+   UDST must be below PHYS_BASE.
+   Returns true if successful, false if a segfault occurred. */
+static inline bool
+put_user (uint8_t *udst, uint8_t byte)
+{
+  int eax;
+  asm ("movl $1f, %%eax; movb %b2, %0; 1:"
+       : "=m" (*udst), "=&a" (eax) : "q" (byte));
+  return eax != 0;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.
+   Call thread_exit() if any of the user accesses are invalid. */
+static void
+copy_in (void *dst_, const void *usrc_, size_t size)
+{
+  uint8_t *dst = dst_;
+  const uint8_t *usrc = usrc_;
+
+  for (; size > 0; size--, dst++, usrc++)
+    if (usrc >= (uint8_t *) PHYS_BASE || !get_user (dst, usrc))
+      thread_exit ();
+}
+
+/* Creates a copy of user string US in kernel memory
+   and returns it as a page that must be freed with
+   palloc_free_page().
+   Truncates the string at PGSIZE bytes in size.
+   Call thread_exit() if any of the user accesses are invalid. */
+static char *
+copy_in_string (const char *us)
+{
+  char *ks;
+  size_t length;
+
+  ks = palloc_get_page (0);
+  if (ks == NULL)
+    thread_exit ();
+
+  for (length = 0; length < PGSIZE; length++)
+    {
+      if (us >= (char *) PHYS_BASE || !get_user ((uint8_t *) ks + length,
+                                                 (uint8_t *) us++))
+        {
+          palloc_free_page (ks);
+          thread_exit ();
+        }
+
+      if (ks[length] == '\0')
+        return ks;
+    }
+  ks[PGSIZE - 1] = '\0';
+  return ks;
+}
+
+/* Most bytes of a user buffer pinned in memory at once.  Larger
+   buffers are transferred in pieces. */
+#define PIN_MAX (16 * PGSIZE)
+
+/* Makes the SIZE bytes of user memory at UADDR safe for file
+   system code to access directly, while it holds file system
+   locks:
+   verifies that they are mapped, and writable if WRITE is true,
+   and keeps them in memory until unpin_user_buffer().  Calls
+   thread_exit() if any of them are invalid. */
+static void
+pin_user_buffer (const void *uaddr, size_t size, bool write)
+{
+  const uint8_t *start = uaddr;
+  const uint8_t *end = start + size;
+
+  if (size == 0)
+    return;
+  if (end < start || end > (uint8_t *) PHYS_BASE)
+    thread_exit ();
+
+#ifdef VM
+  if (!page_pin_range (uaddr, size, write))
+    thread_exit ();
+#else
+  {
+    /* Without virtual memory, mapped pages stay mapped, so it is
+       enough to touch each one. */
+    const uint8_t *upage;
+
+    for (upage = pg_round_down (start); upage < end; upage += PGSIZE)
+      {
+        const uint8_t *uaddr = upage < start ? start : upage;
+        uint8_t byte;
+
+        if (!get_user (&byte, uaddr)
+            || (write && !put_user ((uint8_t *) uaddr, byte)))
+          thread_exit ();
+      }
+  }
+#endif
+}
+
+/* Releases the SIZE bytes of user memory at UADDR, which must
+   have been passed to pin_user_buffer(). */
+static void
+unpin_user_buffer (const void *uaddr UNUSED, size_t size UNUSED)
+{
+#ifdef VM
+  page_unpin_range (uaddr, size);
+#endif
+}
+
+/* Halt system call. */
+static int
+sys_halt (void)
+{
+  shutdown_power_off ();
+}
+
+/* Exit system call. */
+static int
+sys_exit (int exit_code)
+{
+  thread_current ()->exit_code = exit_code;
   thread_exit ();
+  NOT_REACHED ();
+}
+
+/* Exec system call. */
+static int
+sys_exec (const char *ufile)
+{
+  tid_t tid;
+  char *kfile = copy_in_string (ufile);
+
+  tid = process_execute (kfile);
+
+  palloc_free_page (kfile);
+
+  return tid;
+}
+
+/* Wait system call. */
+static int
+sys_wait (tid_t child)
+{
+  return process_wait (child);
+}
+
+/* Create system call. */
+static int
+sys_create (const char *ufile, unsigned initial_size)
+{
+  char *kfile = copy_in_string (ufile);
+  bool ok;
+
+  ok = filesys_create (kfile, initial_size);
+  palloc_free_page (kfile);
+
+  return ok;
+}
+
+/* Remove system call. */
+static int
+sys_remove (const char *ufile)
+{
+  char *kfile = copy_in_string (ufile);
+  bool ok;
+
+  ok = filesys_remove (kfile);
+  palloc_free_page (kfile);
+
+  return ok;
+}
+
+/* Open system call. */
+static int
+sys_open (const char *ufile)
+{
+  char *kfile = copy_in_string (ufile);
+  struct file *file;
+  int handle = -1;
+
+  file = filesys_open (kfile);
+  if (file != NULL)
+    {
+      handle = fd_alloc (&thread_current ()->fds, file);
+      if (handle < 0)
+        file_close (file);
+    }
+
+  palloc_free_page (kfile);
+  return handle;
+}
+
+/* Returns the file associated with the given handle.
+   Terminates the process if HANDLE is not associated with an
+   open file. */
+static struct file *
+lookup_file (int handle)
+{
+  struct file *file = fd_lookup (&thread_current ()->fds, handle);
+  if (file == NULL)
+    thread_exit ();
+  return file;
+}
+
+/* Filesize system call. */
+static int
+sys_filesize (int handle)
+{
+  return file_length (lookup_file (handle));
+}
+
+/* Reads SIZE bytes from HANDLE into user buffer UDST, starting
+   at file offset OFS, or at the file's current position if OFS
+   is negative.  Returns the number of bytes read, or -1 if
+   nothing could be read. */
+static int
+read_handle (int handle, uint8_t *udst, size_t size, off_t ofs)
+{
+  struct file *file;
+  int bytes_read = 0;
+
+  /* Handle keyboard reads. */
+  if (handle == STDIN_FILENO)
+    {
+      for (bytes_read = 0; (size_t) bytes_read < size; bytes_read++)
+        if (udst >= (uint8_t *) PHYS_BASE || !put_user (udst++, input_getc ()))
+          thread_exit ();
+      return bytes_read;
+    }
+
+  /* Handle all other reads. */
+  file = lookup_file (handle);
+  while (size > 0)
+    {
+      /* Read into as much of the buffer as may be pinned. */
+      size_t chunk_size = size < PIN_MAX ? size : PIN_MAX;
+      off_t retval;
+
+      pin_user_buffer (udst, chunk_size, true);
+      if (ofs < 0)
+        retval = file_read (file, udst, chunk_size);
+      else
+        retval = file_read_at (file, udst, chunk_size, ofs + bytes_read);
+      unpin_user_buffer (udst, chunk_size);
+
+      if (retval < 0)
+        {
+          if (bytes_read == 0)
+            bytes_read = -1;
+          break;
+        }
+      bytes_read += retval;
+      if (retval != (off_t) chunk_size)
+        break;
+
+      udst += retval;
+      size -= retval;
+    }
+
+  return bytes_read;
+}
+
+/* Read system call. */
+static int
+sys_read (int handle, void *udst, unsigned size)
+{
+  return read_handle (handle, udst, size, -1);
+}
+
+/* Writes SIZE bytes from user buffer USRC to HANDLE, starting
+   at file offset OFS, or at the file's current position if OFS
+   is negative.  Returns the number of bytes written, or -1 if
+   nothing could be written. */
+static int
+write_handle (int handle, const uint8_t *usrc, size_t size, off_t ofs)
+{
+  struct file *file = NULL;
+  int bytes_written = 0;
+
+  /* Lookup up file descriptor. */
+  if (handle != STDOUT_FILENO)
+    file = lookup_file (handle);
+
+  while (size > 0)
+    {
+      /* Write from as much of the buffer as may be pinned. */
+      size_t chunk_size = size < PIN_MAX ? size : PIN_MAX;
+      off_t retval;
+
+      pin_user_buffer (usrc, chunk_size, false);
+      if (handle == STDOUT_FILENO)
+        {
+          putbuf ((const char *) usrc, chunk_size);
+          retval = chunk_size;
+        }
+      else if (ofs < 0)
+        retval = file_write (file, usrc, chunk_size);
+      else
+        retval = file_write_at (file, usrc, chunk_size, ofs + bytes_written);
+      unpin_user_buffer (usrc, chunk_size);
+
+      if (retval < 0)
+        {
+          if (bytes_written == 0)
+            bytes_written = -1;
+          break;
+        }
+      bytes_written += retval;
+
+      /* If it was a short write we're done. */
+      if (retval != (off_t) chunk_size)
+        break;
+
+      /* Advance. */
+      usrc += retval;
+      size -= retval;
+    }
+
+  return bytes_written;
+}
+
+/* Write system call. */
+static int
+sys_write (int handle, const void *usrc, unsigned size)
+{
+  return write_handle (handle, usrc, size, -1);
+}
+
+/* Seek system call. */
+static int
+sys_seek (int handle, unsigned position)
+{
+  struct file *file = lookup_file (handle);
+
+  if ((off_t) position >= 0)
+    file_seek (file, position);
+  return 0;
+}
+
+/* Tell system call. */
+static int
+sys_tell (int handle)
+{
+  return file_tell (lookup_file (handle));
+}
+
+/* Close system call. */
+static int
+sys_close (int handle)
+{
+  struct file *file = lookup_file (handle);
+
+  fd_free (&thread_current ()->fds, handle);
+  file_close (file);
+  return 0;
+}
+
+#ifdef VM
+/* Mmap system call. */
+static int
+sys_mmap (int handle, void *addr)
+{
+  return mmap_map (lookup_file (handle), addr);
+}
+
+/* Munmap system call. */
+static int
+sys_munmap (int mapping)
+{
+  if (!mmap_unmap (mapping))
+    thread_exit ();
+  return 0;
+}
+#endif
+
+/* Pread system call.  Unlike read, reads at offset OFS without
+   using or moving the file position. */
+static int
+sys_pread (int handle, void *udst, unsigned size, unsigned ofs)
+{
+  if (handle == STDIN_FILENO || (off_t) ofs < 0)
+    return -1;
+  return read_handle (handle, udst, size, ofs);
+}
+
+/* Pwrite system call.  Unlike write, writes at offset OFS
+   without using or moving the file position. */
+static int
+sys_pwrite (int handle, const void *usrc, unsigned size, unsigned ofs)
+{
+  if (handle == STDOUT_FILENO || (off_t) ofs < 0)
+    return -1;
+  return write_handle (handle, usrc, size, ofs);
+}
+
+/* Readv system call.  Reads into the IOV_CNT buffers described
+   by UIOV in turn, stopping early at end of file. */
+static int
+sys_readv (int handle, const struct iovec *uiov, int iov_cnt)
+{
+  int bytes_read = 0;
+  int i;
+
+  if (iov_cnt < 0 || iov_cnt > IOV_MAX)
+    return -1;
+  for (i = 0; i < iov_cnt; i++)
+    {
+      struct iovec iov;
+      int retval;
+
+      copy_in (&iov, uiov + i, sizeof iov);
+      retval = read_handle (handle, iov.iov_base, iov.iov_len, -1);
+      if (retval < 0)
+        return bytes_read > 0 ? bytes_read : -1;
+      bytes_read += retval;
+      if ((size_t) retval != iov.iov_len)
+        break;
+    }
+  return bytes_read;
+}
+
+/* Writev system call.  Writes the IOV_CNT buffers described by
+   UIOV in turn, stopping early on a short write. */
+static int
+sys_writev (int handle, const struct iovec *uiov, int iov_cnt)
+{
+  int bytes_written = 0;
+  int i;
+
+  if (iov_cnt < 0 || iov_cnt > IOV_MAX)
+    return -1;
+  for (i = 0; i < iov_cnt; i++)
+    {
+      struct iovec iov;
+      int retval;
+
+      copy_in (&iov, uiov + i, sizeof iov);
+      retval = write_handle (handle, iov.iov_base, iov.iov_len, -1);
+      if (retval < 0)
+        return bytes_written > 0 ? bytes_written : -1;
+      bytes_written += retval;
+      if ((size_t) retval != iov.iov_len)
+        break;
+    }
+  return bytes_written;
+}
+
+/* On thread exit, close all open files. */
+void
+syscall_exit (void)
+{
+  struct fd_table *fds = &thread_current ()->fds;
+  size_t handle;
+
+  for (handle = 0; handle < fds->size; handle++)
+    {
+      struct file *file = fd_free (fds, handle);
+      if (file != NULL)
+        file_close (file);
+    }
+  fd_table_destroy (fds);
+}
+
+/* Returns a comparison of the system calls whose numbers A_ and
+   B_ point to, in order of decreasing cycles and then decreasing
+   invocations in the profile AUX. */
+static int
+compare_calls (const void *a_, const void *b_, void *aux) 
+{
+  const struct syscall_stats *stats = aux;
+  unsigned a = *(const unsigned *) a_;
+  unsigned b = *(const unsigned *) b_;
+
+  if (stats->cycles[a] != stats->cycles[b])
+    return stats->cycles[a] > stats->cycles[b] ? -1 : 1;
+  else if (stats->calls[a] != stats->calls[b])
+    return stats->calls[a] > stats->calls[b] ? -1 : 1;
+  else
+    return a < b ? -1 : a > b;
+}
+
+/* Prints the system calls made in profile STATS, most expensive
+   first, each line prefixed by PREFIX. */
+static void
+print_stats (const char *prefix, const struct syscall_stats *stats) 
+{
+  unsigned order[SYSCALL_CNT];
+  unsigned call_cnt = 0;
+  uint64_t cycles = 0;
+  size_t i;
+
+  for (i = 0; i < SYSCALL_CNT; i++) 
+    {
+      order[i] = i;
+      call_cnt += stats->calls[i];
+      cycles += stats->cycles[i];
+    }
+  sort (order, SYSCALL_CNT, sizeof *order, compare_calls,
+        (void *) stats);
+
+  printf ("%s: %u system calls in %"PRIu64" cycles\n",
+          prefix, call_cnt, cycles);
+  for (i = 0; i < SYSCALL_CNT; i++) 
+    {
+      unsigned nr = order[i];
+
+      if (stats->calls[nr] == 0)
+        break;
+      printf ("%s:   %-8s %8u calls %12"PRIu64" cycles %8"PRIu64" avg\n",
+              prefix, syscall_table[nr].name, stats->calls[nr],
+              stats->cycles[nr], stats->cycles[nr] / stats->calls[nr]);
+    }
+}
+
+/* Prints the running process's system call profile. */
+void
+syscall_print_process_stats (void) 
+{
+  struct thread *t = thread_current ();
+  print_stats (t->name, &t->syscall_stats);
+}
+
+/* Prints the system call profile for all processes, if
+   -scstats was given. */
+void
+syscall_print_stats (void) 
+{
+  if (syscall_stats_enabled)
+    print_stats ("Syscall", &syscall_stats);
 }
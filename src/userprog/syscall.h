@@ -1,6 +1,28 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <syscall-nr.h>
+#include "threads/synch.h"
+
+/* Number of system call numbers. */
+#define SYSCALL_CNT (SYS_WRITEV + 1)
+
+/* System call profile, kept per process and for the system as a
+   whole. */
+struct syscall_stats
+  {
+    unsigned calls[SYSCALL_CNT];        /* Invocations, by number. */
+    uint64_t cycles[SYSCALL_CNT];       /* Cycles spent, by number. */
+  };
+
+/* -scstats: Print system call profiles? */
+extern bool syscall_stats_enabled;
+
 void syscall_init (void);
+void syscall_exit (void);
+void syscall_print_process_stats (void);
+void syscall_print_stats (void);
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,82 @@
+#include "vm/evict.h"
+#include <debug.h>
+#include <stddef.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "vm/frame.h"
+
+/* Clock: the second-chance algorithm.  Evicts the first frame
+   not accessed since the hand last passed it. */
+static bool
+clock_choose (struct frame *f, unsigned sweep UNUSED) 
+{
+  return !frame_accessed_recently (f);
+}
+
+/* Enhanced second chance.  Classifies frames by their accessed
+   and dirty bits, and prefers clean frames, which can be evicted
+   without writing them out.  Even sweeps look for a frame that
+   is neither accessed nor dirty, without changing anything.  Odd
+   sweeps settle for any frame not accessed, clearing accessed
+   bits along the way as the clock does. */
+static bool
+esc_choose (struct frame *f, unsigned sweep) 
+{
+  if (sweep % 2 == 0)
+    return !frame_is_accessed (f) && !frame_is_dirty (f);
+  else
+    return !frame_accessed_recently (f);
+}
+
+/* Working-set window for WSClock, in timer ticks. */
+#define WSCLOCK_TAU TIMER_FREQ
+
+/* WSClock.  Each frame remembers when the hand last found it
+   accessed.  A frame used within the last WSCLOCK_TAU ticks is
+   in its process's working set and is kept.  The first sweep
+   evicts only clean frames outside every working set.  The
+   second also takes dirty ones.  Later sweeps fall back to the
+   clock, so that a process that streams through memory, with
+   every page recently used once, still makes progress. */
+static bool
+wsclock_choose (struct frame *f, unsigned sweep) 
+{
+  int64_t now = timer_ticks ();
+
+  if (frame_accessed_recently (f)) 
+    {
+      f->last_used = now;
+      return false;
+    }
+  if (sweep >= 2)
+    return true;
+  if (now - f->last_used <= WSCLOCK_TAU)
+    return false;
+  return sweep == 1 || !frame_is_dirty (f);
+}
+
+/* Available policies.  The first is the default. */
+static const struct evict_policy policies[] = 
+  {
+    {"clock", 2, clock_choose},
+    {"esc", 4, esc_choose},
+    {"wsclock", 3, wsclock_choose},
+  };
+
+const struct evict_policy *evict_policy = &policies[0];
+
+/* Selects the policy with the given NAME.  Returns true if
+   successful, false if there is no such policy. */
+bool
+evict_set_policy (const char *name) 
+{
+  size_t i;
+
+  for (i = 0; i < sizeof policies / sizeof *policies; i++)
+    if (!strcmp (policies[i].name, name)) 
+      {
+        evict_policy = &policies[i];
+        return true;
+      }
+  return false;
+}
@@ -0,0 +1,31 @@
+#ifndef VM_EVICT_H
+#define VM_EVICT_H
+
+#include <stdbool.h>
+
+struct frame;
+
+/* A page replacement policy.
+
+   When no frame is free, a clock hand sweeps around the frame
+   table.  For each in-use frame that it passes and can lock, and
+   that is not pinned, it asks the policy whether to evict the
+   frame.  The policy may update the frame's state as it goes,
+   for example by clearing accessed bits, so that a frame passed
+   over on one sweep is chosen on a later one. */
+struct evict_policy
+  {
+    const char *name;           /* Name for -evict option. */
+    unsigned sweep_cnt;         /* Sweeps before giving up. */
+
+    /* Returns true to evict locked frame F on sweep number SWEEP,
+       counting from 0. */
+    bool (*choose) (struct frame *f, unsigned sweep);
+  };
+
+/* Policy in use. */
+extern const struct evict_policy *evict_policy;
+
+bool evict_set_policy (const char *name);
+
+#endif /* vm/evict.h */
@@ -0,0 +1,438 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include "vm/evict.h"
+#include "vm/page.h"
+#include "devices/timer.h"
+#include "threads/loader.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+
+/* Every page in the user pool, as a frame.  A frame is
+   "locked" while its contents are being read in or written out,
+   and while its mapping is being changed, and "pinned" while the
+   kernel needs it to stay resident.  A locked or pinned frame is
+   never chosen for eviction. */
+static struct frame *frames;
+static size_t frame_cnt;
+
+/* Protects the clock hand and serializes frame searches. */
+static struct lock scan_lock;
+static size_t hand;
+
+/* Share cache: frames holding read-only file pages, keyed by
+   inode and offset, so that processes running the same
+   executable share a single copy of its text. */
+static struct hash share_cache;
+
+/* Protects share_cache.  May be acquired while holding a frame's
+   lock, but not the other way around. */
+static struct lock share_lock;
+
+static hash_hash_func share_hash;
+static hash_less_func share_less;
+
+/* Takes every page in the user pool for the frame table. */
+void
+frame_init (void) 
+{
+  void *base;
+
+  lock_init (&scan_lock);
+  lock_init (&share_lock);
+  if (!hash_init (&share_cache, share_hash, share_less, NULL))
+    PANIC ("out of memory allocating share cache");
+  
+  frames = malloc (sizeof *frames * init_ram_pages);
+  if (frames == NULL)
+    PANIC ("out of memory allocating page frames");
+
+  while ((base = palloc_get_page (PAL_USER)) != NULL) 
+    {
+      struct frame *f = &frames[frame_cnt++];
+      lock_init (&f->lock);
+      f->base = base;
+      list_init (&f->pages);
+      f->ref_cnt = 0;
+      f->pin_cnt = 0;
+      f->inode = NULL;
+    }
+}
+
+/* Adds PAGE to the pages mapped to frame F, which must be
+   locked. */
+static void
+add_page (struct frame *f, struct page *page) 
+{
+  list_push_back (&f->pages, &page->frame_elem);
+  if (f->ref_cnt++ == 0)
+    f->last_used = timer_ticks ();
+}
+
+/* Removes frame F, which must be locked, from the share cache if
+   it is there. */
+static void
+unshare (struct frame *f) 
+{
+  if (f->inode != NULL) 
+    {
+      lock_acquire (&share_lock);
+      hash_delete (&share_cache, &f->share_elem);
+      lock_release (&share_lock);
+      f->inode = NULL;
+    }
+}
+
+/* Returns true if any page mapped to locked frame F has been
+   accessed recently, clearing the accessed bit of each. */
+bool
+frame_accessed_recently (struct frame *f) 
+{
+  bool accessed = false;
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (page_accessed_recently (list_entry (e, struct page, frame_elem)))
+      accessed = true;
+  return accessed;
+}
+
+/* Returns true if any page mapped to locked frame F has been
+   accessed recently, without clearing any accessed bits. */
+bool
+frame_is_accessed (struct frame *f) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (page_is_accessed (list_entry (e, struct page, frame_elem)))
+      return true;
+  return false;
+}
+
+/* Returns true if evicting locked frame F would require writing
+   out its contents. */
+bool
+frame_is_dirty (struct frame *f) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (page_is_dirty (list_entry (e, struct page, frame_elem)))
+      return true;
+  return false;
+}
+
+/* Finds a free frame, locks it, and assigns it to PAGE.
+   Returns the frame, or a null pointer if every frame is in use
+   or locked.  scan_lock must be held. */
+static struct frame *
+find_free_frame (struct page *page) 
+{
+  size_t i;
+
+  for (i = 0; i < frame_cnt; i++)
+    {
+      struct frame *f = &frames[i];
+      if (!lock_try_acquire (&f->lock))
+        continue;
+      if (f->ref_cnt == 0) 
+        {
+          add_page (f, page);
+          return f;
+        } 
+      lock_release (&f->lock);
+    }
+  return NULL;
+}
+
+/* Advances the clock hand and returns the frame it passed over. */
+static struct frame *
+advance_hand (void) 
+{
+  struct frame *f = &frames[hand];
+  if (++hand >= frame_cnt)
+    hand = 0;
+  return f;
+}
+
+/* Continues the clock sweep a little way past a chosen victim,
+   collecting and locking up to MAX_CNT more frames that the
+   eviction policy would choose on its first sweep into VICTIMS.
+   Returns the number collected.  scan_lock must be held. */
+static size_t
+gather_victims (struct frame *victims[], size_t max_cnt) 
+{
+  size_t cnt = 0;
+  size_t i;
+
+  for (i = 0; i < 2 * PAGE_CLUSTER && cnt < max_cnt; i++) 
+    {
+      struct frame *f = advance_hand ();
+
+      if (!lock_try_acquire (&f->lock))
+        continue;
+      if (f->ref_cnt == 0 || f->pin_cnt > 0
+          || !evict_policy->choose (f, 0)) 
+        {
+          lock_release (&f->lock);
+          continue;
+        }
+      victims[cnt++] = f;
+    }
+  return cnt;
+}
+
+/* Tries to allocate and lock a frame for PAGE.
+   Returns the frame if successful, a null pointer on failure. */
+static struct frame *
+try_frame_alloc_and_lock (struct page *page) 
+{
+  struct frame *f;
+  size_t i;
+
+  lock_acquire (&scan_lock);
+
+  /* Find a free frame. */
+  f = find_free_frame (page);
+  if (f != NULL) 
+    {
+      lock_release (&scan_lock);
+      return f;
+    }
+
+  /* No free frame.  Find a frame to evict by sweeping the clock
+     hand around the frame table, letting the eviction policy
+     choose.  Its last sweep always chooses a frame, unless every
+     frame is locked or pinned. */
+  for (i = 0; i < frame_cnt * evict_policy->sweep_cnt; i++) 
+    {
+      struct frame *victims[PAGE_CLUSTER];
+      size_t victim_cnt;
+      size_t j;
+
+      f = advance_hand ();
+      if (!lock_try_acquire (&f->lock))
+        continue;
+
+      if (f->ref_cnt == 0) 
+        {
+          add_page (f, page);
+          lock_release (&scan_lock);
+          return f;
+        } 
+
+      if (f->pin_cnt > 0 || !evict_policy->choose (f, i / frame_cnt)) 
+        {
+          lock_release (&f->lock);
+          continue;
+        }
+
+      /* Evict this frame, together with a cluster of other cold
+         frames, so that their swap writes form a single
+         sequential run.  The rest of the cluster becomes free
+         frames for the faults that follow. */
+      victims[0] = f;
+      victim_cnt = 1 + gather_victims (victims + 1, PAGE_CLUSTER - 1);
+      lock_release (&scan_lock);
+
+      page_out (victims, victim_cnt);
+      for (j = 0; j < victim_cnt; j++) 
+        if (victims[j]->ref_cnt == 0)
+          unshare (victims[j]);
+
+      /* page_out() reorders VICTIMS, so F need not still be
+         first.  Keep F locked and release the rest. */
+      for (j = 0; j < victim_cnt; j++) 
+        if (victims[j] != f)
+          lock_release (&victims[j]->lock);
+
+      if (f->ref_cnt != 0)
+        {
+          lock_release (&f->lock);
+          return NULL;
+        }
+      add_page (f, page);
+      return f;
+    }
+
+  lock_release (&scan_lock);
+  return NULL;
+}
+
+/* Tries really hard to allocate and lock a frame for PAGE.
+   Returns the frame if successful, a null pointer on failure. */
+struct frame *
+frame_alloc_and_lock (struct page *page) 
+{
+  size_t try;
+
+  for (try = 0; try < 3; try++) 
+    {
+      struct frame *f = try_frame_alloc_and_lock (page);
+      if (f != NULL) 
+        {
+          ASSERT (lock_held_by_current_thread (&f->lock));
+          return f; 
+        }
+      timer_msleep (1000);
+    }
+
+  return NULL;
+}
+
+/* Allocates and locks a frame for PAGE only if one is free
+   already, without evicting anything.  Returns the frame, or a
+   null pointer if none is free. */
+struct frame *
+frame_alloc_free_and_lock (struct page *page) 
+{
+  struct frame *f;
+
+  lock_acquire (&scan_lock);
+  f = find_free_frame (page);
+  lock_release (&scan_lock);
+  return f;
+}
+
+/* Looks up the frame holding the page at OFFSET in the file
+   with the given INODE in the share cache.  If there is one,
+   locks it, maps PAGE to it as well, and returns it.  Otherwise,
+   returns a null pointer. */
+struct frame *
+frame_share_and_lock (struct page *page, struct inode *inode, off_t offset) 
+{
+  for (;;) 
+    {
+      struct frame key;
+      struct hash_elem *e;
+      struct frame *f;
+
+      key.inode = inode;
+      key.offset = offset;
+      lock_acquire (&share_lock);
+      e = hash_find (&share_cache, &key.share_elem);
+      lock_release (&share_lock);
+      if (e == NULL)
+        return NULL;
+
+      /* The frame may be evicted before we can lock it.  Then its
+         inode and offset change, and we look again. */
+      f = hash_entry (e, struct frame, share_elem);
+      lock_acquire (&f->lock);
+      if (f->inode == inode && f->offset == offset) 
+        {
+          add_page (f, page);
+          return f;
+        }
+      lock_release (&f->lock);
+    }
+}
+
+/* Enters locked frame F, which holds the page at OFFSET in the
+   file with the given INODE, into the share cache, unless
+   another frame already holds that page. */
+void
+frame_share (struct frame *f, struct inode *inode, off_t offset) 
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  ASSERT (f->inode == NULL);
+
+  f->inode = inode;
+  f->offset = offset;
+  lock_acquire (&share_lock);
+  if (hash_insert (&share_cache, &f->share_elem) != NULL)
+    f->inode = NULL;
+  lock_release (&share_lock);
+}
+
+/* Locks P's frame into memory, if it has one.
+   Upon return, p->frame will not change until P is unlocked. */
+void
+frame_lock (struct page *p) 
+{
+  /* A frame can be asynchronously removed, but never inserted. */
+  struct frame *f = p->frame;
+  if (f != NULL) 
+    {
+      lock_acquire (&f->lock);
+      if (f != p->frame)
+        {
+          lock_release (&f->lock);
+          ASSERT (p->frame == NULL); 
+        } 
+    }
+}
+
+/* Removes page P from the pages mapped to frame F, and unlocks
+   F.  F must be locked for use by the current process.  When no
+   pages remain, F is released for use by another page and any
+   data in it is lost. */
+void
+frame_free (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+
+  list_remove (&p->frame_elem);
+  p->frame = NULL;
+  if (--f->ref_cnt == 0) 
+    {
+      unshare (f);
+      f->pin_cnt = 0;
+    }
+  lock_release (&f->lock);
+}
+
+/* Pins frame F, which must be locked, so that it will not be
+   evicted until a matching call to frame_unpin().  Unlike the
+   frame's lock, a pin may be held for a long time, such as
+   across file system operations in a system call, and a frame
+   may be pinned several times over. */
+void
+frame_pin (struct frame *f) 
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  f->pin_cnt++;
+}
+
+/* Removes one pin from frame F, which must be locked. */
+void
+frame_unpin (struct frame *f) 
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  ASSERT (f->pin_cnt > 0);
+  f->pin_cnt--;
+}
+
+/* Unlocks frame F, allowing it to be evicted.
+   F must be locked for use by the current process. */
+void
+frame_unlock (struct frame *f) 
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  lock_release (&f->lock);
+}
+
+/* Returns a hash value for the frame that E refers to. */
+static unsigned
+share_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  const struct frame *f = hash_entry (e, struct frame, share_elem);
+  return hash_bytes (&f->inode, sizeof f->inode) ^ hash_int (f->offset);
+}
+
+/* Returns true if frame A precedes frame B. */
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED) 
+{
+  const struct frame *a = hash_entry (a_, struct frame, share_elem);
+  const struct frame *b = hash_entry (b_, struct frame, share_elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  return a->offset < b->offset;
+}
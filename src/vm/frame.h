@@ -0,0 +1,59 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct inode;
+struct page;
+
+/* A physical frame of user memory.
+
+   A frame normally holds one process's page.  A frame holding a
+   read-only page of a file may instead be shared by every
+   process that maps the same page of the same file: it is then
+   entered in the share cache under its inode and offset, and
+   each sharer's page is on its `pages' list. */
+struct frame 
+  {
+    struct lock lock;           /* Locks the frame against eviction
+                                   while it is being changed. */
+    void *base;                 /* Kernel virtual base address. */
+    struct list pages;          /* Mapped pages.  Each one's thread
+                                   and address give an owner and
+                                   user page of the frame. */
+    size_t ref_cnt;             /* Number of pages in `pages'. */
+    unsigned pin_cnt;           /* Pins against eviction, e.g. by
+                                   system calls using the frame. */
+    int64_t last_used;          /* Timer tick when last seen in use. */
+
+    /* Share cache.  INODE is null if the frame is not shared. */
+    struct inode *inode;        /* File's inode. */
+    off_t offset;               /* Page's offset in the file. */
+    struct hash_elem share_elem; /* Element in share cache. */
+  };
+
+void frame_init (void);
+
+struct frame *frame_alloc_and_lock (struct page *);
+struct frame *frame_alloc_free_and_lock (struct page *);
+struct frame *frame_share_and_lock (struct page *,
+                                    struct inode *, off_t offset);
+void frame_share (struct frame *, struct inode *, off_t offset);
+void frame_lock (struct page *);
+
+bool frame_accessed_recently (struct frame *);
+bool frame_is_accessed (struct frame *);
+bool frame_is_dirty (struct frame *);
+
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+
+void frame_free (struct frame *, struct page *);
+void frame_unlock (struct frame *);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,128 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* A memory-mapped file. */
+struct mapping
+  {
+    struct list_elem elem;      /* Element in thread's `mappings'. */
+    mapid_t handle;             /* Mapping identifier. */
+    struct file *file;          /* Mapped file. */
+    uint8_t *base;              /* Start of memory mapping. */
+    size_t page_cnt;            /* Number of pages mapped. */
+  };
+
+static void unmap (struct mapping *);
+
+/* Maps FILE into the running process's address space, starting
+   at ADDR, which must be page-aligned.  Nothing is read yet: each
+   page is faulted in from the file on its first access, and
+   written back only if it was modified, on munmap or exit or
+   when it is evicted.  Returns the new mapping's identifier, or
+   MAP_FAILED if FILE is empty or if the pages it needs are not
+   all free. */
+mapid_t
+mmap_map (struct file *file, void *addr) 
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  off_t offset;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+
+  /* The mapping keeps its own file, so that it survives the file
+     descriptor being closed. */
+  m->file = file_reopen (file);
+  if (m->file == NULL) 
+    {
+      free (m);
+      return MAP_FAILED;
+    }
+  m->base = addr;
+  m->page_cnt = 0;
+
+  length = file_length (m->file);
+  if (length == 0)
+    goto error;
+  for (offset = 0; offset < length; offset += PGSIZE) 
+    {
+      void *upage = m->base + offset;
+      struct page *p;
+
+      if (!is_user_vaddr (upage)
+          || (p = page_allocate (upage, true)) == NULL)
+        goto error;
+      p->mmap = true;
+      p->file = m->file;
+      p->file_offset = offset;
+      p->read_bytes = length - offset < PGSIZE ? length - offset : PGSIZE;
+      m->page_cnt++;
+    }
+
+  m->handle = t->next_mapping++;
+  list_push_front (&t->mappings, &m->elem);
+  return m->handle;
+
+ error:
+  unmap (m);
+  return MAP_FAILED;
+}
+
+/* Removes the running process's mapping with the given HANDLE.
+   Returns true if successful, false if there is no such
+   mapping. */
+bool
+mmap_unmap (mapid_t handle) 
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->handle == handle) 
+        {
+          list_remove (&m->elem);
+          unmap (m);
+          return true;
+        }
+    }
+  return false;
+}
+
+/* Removes all of the running process's mappings. */
+void
+mmap_unmap_all (void) 
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings)) 
+    unmap (list_entry (list_pop_front (&t->mappings),
+                       struct mapping, elem));
+}
+
+/* Unmaps each page of M, writing back those that were
+   modified, and frees M. */
+static void
+unmap (struct mapping *m) 
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_deallocate (m->base + i * PGSIZE);
+  file_close (m->file);
+  free (m);
+}
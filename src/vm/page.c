@@ -0,0 +1,700 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Maximum size of a process's stack, in pages.  Set by the
+   kernel command-line option -sl. */
+size_t stack_page_limit = 2048;
+
+/* Print each process's page_stats when it exits?  Set by the
+   kernel command-line option -vmstats. */
+bool page_stats_enabled;
+
+/* A page of zeros, mapped read-only in place of every all-zero
+   page that has been read but not yet written.  It is not part
+   of the frame table and is never evicted. */
+static void *zero_page;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func destroy_page;
+static void unmap_zero_page (struct page *);
+static void remove_resident (struct page *);
+static void release_page (struct page *);
+static void swap_in_neighbors (struct page *, size_t slot);
+
+/* Initializes the page module. */
+void
+page_init (void) 
+{
+  zero_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+/* Initializes the running process's supplemental page table
+   and its list of memory mappings.  Returns true if successful,
+   false if memory allocation fails. */
+bool
+page_table_create (void) 
+{
+  struct thread *t = thread_current ();
+
+  list_init (&t->mappings);
+  t->next_mapping = 0;
+  return hash_init (&t->pages, page_hash, page_less, NULL);
+}
+
+/* Destroys the running process's supplemental page table,
+   releasing every frame it maps.  Must be called before the
+   process's page directory is destroyed. */
+void
+page_table_destroy (void) 
+{
+  hash_destroy (&thread_current ()->pages, destroy_page);
+}
+
+/* Frees the page in hash element E, along with its frame. */
+static void
+destroy_page (struct hash_elem *e, void *aux UNUSED) 
+{
+  release_page (hash_entry (e, struct page, hash_elem));
+}
+
+/* Removes the page at user virtual address ADDR from the running
+   process's address space, writing it back to its file first if
+   it is a modified page of a memory-mapped file. */
+void
+page_deallocate (void *addr) 
+{
+  struct page *p = page_lookup (addr);
+
+  ASSERT (p != NULL);
+  hash_delete (&thread_current ()->pages, &p->hash_elem);
+  release_page (p);
+}
+
+/* Frees page P, which is no longer in its supplemental page
+   table, along with its frame or swap slot. */
+static void
+release_page (struct page *p) 
+{
+  unmap_zero_page (p);
+  frame_lock (p);
+  if (p->frame != NULL)
+    {
+      pagedir_clear_page (p->thread->pagedir, p->addr);
+      if (p->mmap && pagedir_is_dirty (p->thread->pagedir, p->addr))
+        file_write_at (p->file, p->frame->base, p->read_bytes,
+                       p->file_offset);
+      frame_free (p->frame, p);
+      remove_resident (p);
+    }
+  else if (p->swap_slot != SWAP_ERROR)
+    swap_discard (p->swap_slot);
+  free (p);
+}
+
+/* Adds a page at user virtual address ADDR, which must be page
+   aligned, to the running process's supplemental page table.
+   The page is initially all zeros; the caller may set its
+   `file' members to fill it from a file instead.  It is mapped
+   read-only unless WRITABLE is true.  Returns the new page, or a
+   null pointer if ADDR is already in use or if memory allocation
+   fails. */
+struct page *
+page_allocate (void *addr, bool writable) 
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+
+  ASSERT (pg_ofs (addr) == 0);
+  ASSERT (is_user_vaddr (addr));
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->addr = addr;
+  p->writable = writable;
+  p->thread = t;
+  p->frame = NULL;
+  p->swap_slot = SWAP_ERROR;
+  p->private = false;
+  p->mmap = false;
+  p->zero_mapped = false;
+  p->file = NULL;
+  p->file_offset = 0;
+  p->read_bytes = 0;
+  if (hash_insert (&t->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Returns the page in the running process's supplemental page
+   table that contains user virtual address ADDR, or a null
+   pointer if there is none. */
+struct page *
+page_lookup (const void *addr) 
+{
+  struct thread *t = thread_current ();
+  struct page p;
+  struct hash_elem *e;
+
+  if (!is_user_vaddr (addr))
+    return NULL;
+  p.addr = pg_round_down (addr);
+  e = hash_find (&t->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Returns true if page P may share its frame with the same page
+   of the same file in other processes.  Such pages cannot be
+   modified, so their frames never need to be written back. */
+static bool
+page_is_shared (const struct page *p) 
+{
+  return p->file != NULL && !p->writable;
+}
+
+/* Returns true if page P, which has no frame, is all zeros. */
+static bool
+page_is_zero (const struct page *p) 
+{
+  return p->file == NULL && p->swap_slot == SWAP_ERROR && !p->private;
+}
+
+/* Maps the shared zero page at P's address, read-only, in place
+   of a frame of its own.  Returns true if successful, false if
+   memory allocation fails. */
+static bool
+map_zero_page (struct page *p) 
+{
+  if (!pagedir_set_page (p->thread->pagedir, p->addr, zero_page, false))
+    return false;
+  p->zero_mapped = true;
+  return true;
+}
+
+/* Removes P's mapping of the shared zero page, if it has one.
+   This must happen before P gets a frame, and before its page
+   directory is destroyed, which would otherwise free the zero
+   page. */
+static void
+unmap_zero_page (struct page *p) 
+{
+  if (p->zero_mapped) 
+    {
+      pagedir_clear_page (p->thread->pagedir, p->addr);
+      p->zero_mapped = false;
+    }
+}
+
+/* Adds 1 to *COUNTER, one of the fields of a process's
+   page_stats.  A process's evictions are counted by whichever
+   process evicts its pages, so the fields are only updated with
+   interrupts disabled. */
+static void
+count_event (unsigned *counter) 
+{
+  enum intr_level old_level = intr_disable ();
+  ++*counter;
+  intr_set_level (old_level);
+}
+
+/* Counts a frame newly mapped by page P's process. */
+static void
+add_resident (struct page *p) 
+{
+  struct page_stats *s = &p->thread->page_stats;
+  enum intr_level old_level = intr_disable ();
+  if (++s->resident > s->peak_resident)
+    s->peak_resident = s->resident;
+  intr_set_level (old_level);
+}
+
+/* Counts a frame no longer mapped by page P's process. */
+static void
+remove_resident (struct page *p) 
+{
+  enum intr_level old_level = intr_disable ();
+  p->thread->page_stats.resident--;
+  intr_set_level (old_level);
+}
+
+/* Locks a frame for page P and pages it in.
+   Returns true if successful, false on failure. */
+static bool
+do_page_in (struct page *p) 
+{
+  /* Use another process's copy of a shared page, if there is
+     one. */
+  if (page_is_shared (p)) 
+    {
+      p->frame = frame_share_and_lock (p, file_get_inode (p->file),
+                                       p->file_offset);
+      if (p->frame != NULL) 
+        {
+          count_event (&p->thread->page_stats.minor_faults);
+          add_resident (p);
+          return true;
+        }
+    }
+
+  /* Get a frame for the page. */
+  p->frame = frame_alloc_and_lock (p);
+  if (p->frame == NULL)
+    return false;
+
+  /* Copy data into the frame. */
+  if (p->swap_slot != SWAP_ERROR) 
+    {
+      /* Get data from swap. */
+      size_t slot = p->swap_slot;
+      swap_in (slot, p->frame->base);
+      p->swap_slot = SWAP_ERROR;
+      count_event (&p->thread->page_stats.major_faults);
+      count_event (&p->thread->page_stats.swap_ins);
+      swap_in_neighbors (p, slot);
+    }
+  else if (p->file != NULL) 
+    {
+      /* Get data from file. */
+      off_t read_bytes = file_read_at (p->file, p->frame->base,
+                                       p->read_bytes, p->file_offset);
+      if (read_bytes != p->read_bytes) 
+        {
+          frame_free (p->frame, p);
+          return false;
+        }
+      memset ((uint8_t *) p->frame->base + read_bytes, 0,
+              PGSIZE - read_bytes);
+      if (page_is_shared (p))
+        frame_share (p->frame, file_get_inode (p->file), p->file_offset);
+      count_event (&p->thread->page_stats.major_faults);
+    }
+  else 
+    {
+      /* Provide all-zero page. */
+      memset (p->frame->base, 0, PGSIZE);
+      count_event (&p->thread->page_stats.minor_faults);
+    }
+
+  add_resident (p);
+  return true;
+}
+
+/* Brings the page containing FAULT_ADDR into memory and maps it
+   in the running process's page directory.  WRITE is true if the
+   access that faulted was a write.  Returns true if successful,
+   false if FAULT_ADDR is not part of the process's address space
+   or if the page cannot be loaded, in which case the access that
+   faulted was invalid.
+
+   A read of a page that is still all zeros maps the shared zero
+   page.  The page gets a frame of its own only when it is first
+   written, which faults again. */
+bool
+page_in (void *fault_addr, bool write) 
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  bool success;
+
+  /* Kernel threads have no user address space. */
+  if (t->pagedir == NULL)
+    return false;
+
+  p = page_lookup (fault_addr);
+  if (p == NULL || (write && !p->writable)) 
+    return false; 
+
+  frame_lock (p);
+  if (p->frame == NULL)
+    {
+      if (!write && page_is_zero (p)) 
+        {
+          count_event (&t->page_stats.minor_faults);
+          return p->zero_mapped || map_zero_page (p);
+        }
+
+      unmap_zero_page (p);
+      if (!do_page_in (p))
+        return false;
+    }
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+    
+  /* Install frame into page table. */
+  success = pagedir_set_page (t->pagedir, p->addr, p->frame->base,
+                              p->writable);
+
+  /* Release frame. */
+  frame_unlock (p->frame);
+
+  return success;
+}
+
+/* Brings the page containing user address ADDR into memory, if
+   necessary, and pins its frame so that it stays resident until
+   page_unpin().  If ADDR is just below the stack, grows the stack
+   to cover it.  Fails if ADDR is not part of the running
+   process's address space, or if WILL_WRITE is true and the page
+   is read-only.  Returns true if successful, false on failure. */
+bool
+page_pin (const void *addr, bool will_write) 
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+
+  if (t->pagedir == NULL)
+    return false;
+
+  p = page_lookup (addr);
+  if (p == NULL && page_grow_stack ((void *) addr, t->user_esp))
+    p = page_lookup (addr);
+  if (p == NULL || (will_write && !p->writable))
+    return false;
+
+  frame_lock (p);
+  if (p->frame == NULL) 
+    {
+      unmap_zero_page (p);
+      if (!do_page_in (p))
+        return false;
+
+      /* If mapping fails, the kernel's first access to the page
+         will fault and map it. */
+      pagedir_set_page (t->pagedir, p->addr, p->frame->base, p->writable);
+    }
+  frame_pin (p->frame);
+  frame_unlock (p->frame);
+  return true;
+}
+
+/* Unpins the page containing user address ADDR, which must have
+   been pinned with page_pin(). */
+void
+page_unpin (const void *addr) 
+{
+  struct page *p = page_lookup (addr);
+
+  ASSERT (p != NULL);
+  frame_lock (p);
+  ASSERT (p->frame != NULL);
+  frame_unpin (p->frame);
+  frame_unlock (p->frame);
+}
+
+/* Pins every page in the SIZE bytes of user memory starting at
+   ADDR, as page_pin() does, in one batch, so that a system call
+   can access them without faulting while it holds file system
+   locks.  On failure, unpins whatever was pinned.  Returns true
+   if successful, false on failure. */
+bool
+page_pin_range (const void *addr, size_t size, bool will_write) 
+{
+  const uint8_t *start = pg_round_down (addr);
+  const uint8_t *end = (const uint8_t *) addr + size;
+  const uint8_t *upage;
+
+  if (size == 0)
+    return true;
+  if (end < start)
+    return false;
+
+  for (upage = start; upage < end; upage += PGSIZE)
+    if (!page_pin (upage, will_write)) 
+      {
+        if (upage > start)
+          page_unpin_range (start, upage - start);
+        return false;
+      }
+  return true;
+}
+
+/* Unpins every page in the SIZE bytes of user memory starting at
+   ADDR, which must have been pinned with page_pin_range(). */
+void
+page_unpin_range (const void *addr, size_t size) 
+{
+  const uint8_t *upage = pg_round_down (addr);
+  const uint8_t *end = (const uint8_t *) addr + size;
+
+  if (size == 0)
+    return;
+  for (; upage < end; upage += PGSIZE)
+    page_unpin (upage);
+}
+
+/* Returns true if an access to FAULT_ADDR, with the user stack
+   pointer at ESP, should be treated as a stack access.  The
+   PUSHA instruction checks access permissions up to 32 bytes
+   below the stack pointer before moving it, so faults that far
+   below ESP are accepted too. */
+static bool
+is_stack_access (const void *fault_addr, const void *esp) 
+{
+  const uint8_t *addr = fault_addr;
+  const uint8_t *stack_bottom = (uint8_t *) PHYS_BASE
+                                - stack_page_limit * PGSIZE;
+
+  return (is_user_vaddr (addr)
+          && addr >= stack_bottom
+          && addr + 32 >= (const uint8_t *) esp);
+}
+
+/* Grows the running process's stack down to FAULT_ADDR, if the
+   access that faulted there, with the user stack pointer at ESP,
+   was a stack access within the stack size limit.  Returns true
+   if successful, false if the access was invalid or if memory
+   allocation fails. */
+bool
+page_grow_stack (void *fault_addr, void *esp) 
+{
+  if (thread_current ()->pagedir == NULL
+      || !is_stack_access (fault_addr, esp)
+      || page_allocate (pg_round_down (fault_addr), true) == NULL)
+    return false;
+  return page_in (fault_addr, true);
+}
+
+/* Reads speculatively from swap the pages following P in the
+   address space that were paged out to the slots following
+   SLOT, P's former slot, so that one fault brings in a whole
+   cluster evicted together by page_out().  Only frames that are
+   already free are used, so prefetching never forces an
+   eviction. */
+static void
+swap_in_neighbors (struct page *p, size_t slot) 
+{
+  size_t i;
+
+  for (i = 1; i < PAGE_CLUSTER; i++) 
+    {
+      struct page *q = page_lookup ((uint8_t *) p->addr + i * PGSIZE);
+      if (q == NULL || q->frame != NULL || q->swap_slot != slot + i)
+        break;
+
+      q->frame = frame_alloc_free_and_lock (q);
+      if (q->frame == NULL)
+        break;
+      swap_in (q->swap_slot, q->frame->base);
+      q->swap_slot = SWAP_ERROR;
+      count_event (&q->thread->page_stats.swap_ins);
+      add_resident (q);
+
+      /* Map the page with its accessed bit clear, so that it is
+         the first to go again if the process never touches it.
+         If mapping fails, a fault will map it later. */
+      pagedir_set_page (q->thread->pagedir, q->addr, q->frame->base,
+                        q->writable);
+      frame_unlock (q->frame);
+    }
+}
+
+/* Returns true if page A should be written to swap before page
+   B: pages are grouped by process, in address order. */
+static bool
+swap_order_less (const struct page *a, const struct page *b) 
+{
+  if (a->thread != b->thread)
+    return a->thread < b->thread;
+  return a->addr < b->addr;
+}
+
+/* Returns the page whose contents must go to swap if frame F
+   is evicted, or a null pointer if none need to.  Only an
+   unshared frame can hold such a page. */
+static struct page *
+private_page (struct frame *f) 
+{
+  struct page *p = list_entry (list_front (&f->pages), struct page,
+                               frame_elem);
+  if (!p->private)
+    return NULL;
+  ASSERT (f->ref_cnt == 1);
+  return p;
+}
+
+/* Evicts every page mapped to each of the CNT locked frames in
+   FRAMES, and reorders FRAMES.  Pages that must go to swap are
+   written together as one run of consecutive slots, in the
+   order of swap_order_less(), which lets swap_in_neighbors()
+   read them back together too.  A frame whose page cannot be
+   evicted keeps it; the caller can tell by checking the frame's
+   `ref_cnt'. */
+void
+page_out (struct frame *frames[], size_t cnt) 
+{
+  void *kpages[PAGE_CLUSTER];
+  size_t swap_cnt;
+  size_t slot;
+  size_t i, j;
+
+  ASSERT (cnt <= PAGE_CLUSTER);
+
+  for (i = 0; i < cnt; i++) 
+    {
+      struct frame *f = frames[i];
+      struct list_elem *e;
+
+      ASSERT (lock_held_by_current_thread (&f->lock));
+      ASSERT (f->ref_cnt > 0);
+
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          struct page *p = list_entry (e, struct page, frame_elem);
+
+          /* Mark page not present in page table, forcing accesses
+             by the process to fault.  This must happen before
+             checking the dirty bit, to prevent a race with the
+             process dirtying the page. */
+          pagedir_clear_page (p->thread->pagedir, p->addr);
+
+          /* A modified page of a memory-mapped file is written
+             back to the file.  Any other page, once modified,
+             belongs in swap: its file no longer has its
+             contents. */
+          if (pagedir_is_dirty (p->thread->pagedir, p->addr)) 
+            {
+              if (p->mmap)
+                file_write_at (p->file, f->base, p->read_bytes,
+                               p->file_offset);
+              else
+                p->private = true;
+            }
+        }
+    }
+
+  /* Move the frames bound for swap to the front of FRAMES, in
+     swap order, by insertion sort. */
+  for (i = 1; i < cnt; i++) 
+    {
+      struct frame *f = frames[i];
+      struct page *p = private_page (f);
+      for (j = i; j > 0; j--) 
+        {
+          struct page *prev = private_page (frames[j - 1]);
+          if (p == NULL || (prev != NULL && !swap_order_less (p, prev)))
+            break;
+          frames[j] = frames[j - 1];
+        }
+      frames[j] = f;
+    }
+  for (swap_cnt = 0; swap_cnt < cnt; swap_cnt++) 
+    {
+      if (private_page (frames[swap_cnt]) == NULL)
+        break;
+      kpages[swap_cnt] = frames[swap_cnt]->base;
+    }
+
+  /* Write them out, as one run if possible, else one by one. */
+  slot = swap_cnt > 1 ? swap_out_run (kpages, swap_cnt) : SWAP_ERROR;
+  for (i = 0; i < cnt; i++) 
+    {
+      struct frame *f = frames[i];
+      struct page *p = private_page (f);
+      if (p != NULL) 
+        {
+          p->swap_slot = (slot != SWAP_ERROR ? slot + i
+                          : swap_out (f->base));
+          if (p->swap_slot == SWAP_ERROR)
+            continue;
+          count_event (&p->thread->page_stats.swap_outs);
+        }
+
+      while (!list_empty (&f->pages)) 
+        {
+          p = list_entry (list_pop_front (&f->pages), struct page,
+                          frame_elem);
+          p->frame = NULL;
+          count_event (&p->thread->page_stats.evictions);
+          remove_resident (p);
+        }
+      f->ref_cnt = 0;
+    }
+}
+
+/* Returns true if page P's data has been accessed recently,
+   false otherwise.
+   P must have a frame locked into memory. */
+bool
+page_accessed_recently (struct page *p) 
+{
+  bool was_accessed;
+
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  was_accessed = pagedir_is_accessed (p->thread->pagedir, p->addr);
+  if (was_accessed)
+    pagedir_set_accessed (p->thread->pagedir, p->addr, false);
+  return was_accessed;
+}
+
+/* Returns true if page P's data has been accessed recently,
+   without clearing its accessed bit.
+   P must have a frame locked into memory. */
+bool
+page_is_accessed (struct page *p) 
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  return pagedir_is_accessed (p->thread->pagedir, p->addr);
+}
+
+/* Returns true if page P, which must have a frame locked into
+   memory, would have to be written out to evict it. */
+bool
+page_is_dirty (struct page *p) 
+{
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  return p->private || pagedir_is_dirty (p->thread->pagedir, p->addr);
+}
+
+/* Prints the running process's paging statistics. */
+void
+page_print_stats (void) 
+{
+  struct thread *t = thread_current ();
+  const struct page_stats *s = &t->page_stats;
+
+  printf ("%s: vm: %u minor, %u major faults in %"PRIu64" cycles, "
+          "%u swap-ins, %u swap-outs, %u evictions, %u peak frames\n",
+          t->name, s->minor_faults, s->major_faults, s->fault_cycles,
+          s->swap_ins, s->swap_outs, s->evictions, s->peak_resident);
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return ((uintptr_t) p->addr) >> PGBITS;
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED) 
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->addr < b->addr;
+}
@@ -0,0 +1,90 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+/* A page of user virtual memory, as recorded in its process's
+   supplemental page table.  The supplemental page table knows
+   where to find each page's contents when the page is not in
+   memory, so that pages can be brought in lazily, on the first
+   access that faults. */
+struct page
+  {
+    void *addr;                 /* User virtual address. */
+    bool writable;              /* False to map the page read-only. */
+    struct thread *thread;      /* Owning thread. */
+    struct hash_elem hash_elem; /* Element in thread's `pages'. */
+
+    /* Set only in owning process context with frame->lock held.
+       Cleared only with frame->lock held. */
+    struct frame *frame;        /* Page frame, or null. */
+    struct list_elem frame_elem; /* Element in frame's `pages'. */
+
+    /* Swap information, protected by frame->lock. */
+    size_t swap_slot;           /* Swap slot, or SWAP_ERROR. */
+    bool private;               /* False to discard and reload,
+                                   true to write back to swap. */
+    bool mmap;                  /* Memory-mapped: write back to FILE
+                                   when modified, never to swap. */
+    bool zero_mapped;           /* Mapped to the shared zero page. */
+
+    /* Backing store.  The first READ_BYTES bytes of the page are
+       read from FILE at FILE_OFFSET, and the rest of the page is
+       zeroed.  FILE is null for an all-zero page. */
+    struct file *file;          /* File, or null. */
+    off_t file_offset;          /* Offset in FILE. */
+    off_t read_bytes;           /* Bytes to read, 0...PGSIZE. */
+  };
+
+/* Maximum number of pages evicted at once, and read back
+   together from swap. */
+#define PAGE_CLUSTER 8
+
+/* Paging statistics for a process.  Counters for events that
+   happen to a process's pages in another process, as when it
+   evicts them, are updated by that process, so all of them are
+   updated with interrupts disabled. */
+struct page_stats
+  {
+    unsigned minor_faults;      /* Faults satisfied without I/O. */
+    unsigned major_faults;      /* Faults that read a file or swap. */
+    unsigned swap_ins;          /* Pages read from swap. */
+    unsigned swap_outs;         /* Pages written to swap. */
+    unsigned evictions;         /* Pages evicted from memory. */
+    unsigned resident;          /* Frames mapped now. */
+    unsigned peak_resident;     /* Most frames mapped at once. */
+    uint64_t fault_cycles;      /* CPU cycles in page fault handler. */
+  };
+
+/* Print paging statistics at process exit? */
+extern bool page_stats_enabled;
+
+/* Maximum size of a process's stack, in pages. */
+extern size_t stack_page_limit;
+
+void page_init (void);
+bool page_table_create (void);
+void page_table_destroy (void);
+
+struct page *page_allocate (void *addr, bool writable);
+void page_deallocate (void *addr);
+struct page *page_lookup (const void *addr);
+bool page_in (void *fault_addr, bool write);
+bool page_grow_stack (void *fault_addr, void *esp);
+
+bool page_pin (const void *addr, bool will_write);
+void page_unpin (const void *addr);
+bool page_pin_range (const void *addr, size_t size, bool will_write);
+void page_unpin_range (const void *addr, size_t size);
+
+void page_print_stats (void);
+void page_out (struct frame *[], size_t cnt);
+bool page_accessed_recently (struct page *);
+bool page_is_accessed (struct page *);
+bool page_is_dirty (struct page *);
+
+#endif /* vm/page.h */
@@ -0,0 +1,99 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* The swap device. */
+static struct block *swap_device;
+
+/* Used swap slots, or null if there is no swap device. */
+static struct bitmap *swap_bitmap;
+
+/* Protects swap_bitmap. */
+static struct lock swap_lock;
+
+/* Number of sectors per page. */
+#define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* Sets up swap on the block device in the BLOCK_SWAP role.
+   Without one, pages that must be swapped out cannot be
+   evicted. */
+void
+swap_init (void) 
+{
+  lock_init (&swap_lock);
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL) 
+    {
+      printf ("no swap device--swap disabled\n");
+      return;
+    }
+  swap_bitmap = bitmap_create (block_size (swap_device) / PAGE_SECTORS);
+  if (swap_bitmap == NULL)
+    PANIC ("couldn't create swap bitmap");
+}
+
+/* Writes the page at KPAGE to a free swap slot.
+   Returns the slot, or SWAP_ERROR if swap is full. */
+size_t
+swap_out (const void *kpage) 
+{
+  void *kpages[1];
+
+  kpages[0] = (void *) kpage;
+  return swap_out_run (kpages, 1);
+}
+
+/* Writes the CNT pages in KPAGES to CNT consecutive free swap
+   slots, in order, as one sequential run of sectors.  Returns
+   the first slot, so that KPAGES[i] is in slot (first + i), or
+   SWAP_ERROR if there is no run of CNT free slots. */
+size_t
+swap_out_run (void *const kpages[], size_t cnt) 
+{
+  block_sector_t sector;
+  size_t slot;
+  size_t i, j;
+
+  if (swap_bitmap == NULL)
+    return SWAP_ERROR;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (swap_bitmap, 0, cnt, false);
+  lock_release (&swap_lock);
+  if (slot == BITMAP_ERROR) 
+    return SWAP_ERROR; 
+
+  sector = slot * PAGE_SECTORS;
+  for (i = 0; i < cnt; i++)
+    for (j = 0; j < PAGE_SECTORS; j++)
+      block_write (swap_device, sector++,
+                   (const uint8_t *) kpages[i] + j * BLOCK_SECTOR_SIZE);
+  return slot;
+}
+
+/* Reads swap SLOT into the page at KPAGE and frees the slot. */
+void
+swap_in (size_t slot, void *kpage) 
+{
+  size_t i;
+
+  ASSERT (bitmap_test (swap_bitmap, slot));
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    block_read (swap_device, slot * PAGE_SECTORS + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  swap_discard (slot);
+}
+
+/* Frees swap SLOT without reading it. */
+void
+swap_discard (size_t slot) 
+{
+  lock_acquire (&swap_lock);
+  bitmap_reset (swap_bitmap, slot);
+  lock_release (&swap_lock);
+}
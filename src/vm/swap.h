@@ -0,0 +1,17 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A swap slot holds one page.  SWAP_ERROR is never a valid
+   slot. */
+#define SWAP_ERROR SIZE_MAX
+
+void swap_init (void);
+size_t swap_out (const void *kpage);
+size_t swap_out_run (void *const kpages[], size_t cnt);
+void swap_in (size_t slot, void *kpage);
+void swap_discard (size_t slot);
+
+#endif /* vm/swap.h */